@@ -0,0 +1,193 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+/*
+ * cRandom against the C++ <random> library (std::mt19937_64 with the
+ * standard distributions) on the same parameter grids: ns/sample of both
+ * and the speedup ratio, as JSON on the standard output, with hardware
+ * counters per sample of both sides where perf_event_open is permitted.
+ *
+ *   cc -O2 -DDSFMT_MEXP=19937 -c benchmark.c crandom.c dSFMT/dSFMT.c
+ *   c++ -O2 -std=c++11 bench_baseline.cpp benchmark.o crandom.o dSFMT.o -lm
+ *   ./a.out [samples per repeat] [repeats]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "benchmark.h"
+#include "crandom.h"
+
+
+#define SAMPLES (1 << 22)
+#define REPEATS (5)
+#define BUFFER (1024)
+
+
+static std::mt19937_64 engine(12345);
+
+
+typedef void (* Generate)(struct cRandom * crandom, double * array, size_t size);
+
+
+#define SCALAR(fn, call)                                                  \
+  static void fn(struct cRandom * crandom, double * array, size_t size) { \
+    for(size_t i = 0; i < size; ++i)                                      \
+      array[i] = (double) (call);                                         \
+  }
+
+#define STANDARD(fn, distribution)                                        \
+  static void fn(struct cRandom *, double * array, size_t size) {         \
+    distribution;                                                         \
+    for(size_t i = 0; i < size; ++i)                                      \
+      array[i] = (double) d(engine);                                      \
+  }
+
+
+SCALAR(c_uniform, uniform(crandom, 0.0, 1.0))
+SCALAR(c_equilikely, equilikely(crandom, 1, 6))
+SCALAR(c_exponential, exponential(crandom, 1.0))
+SCALAR(c_normal, normal(crandom, 0.0, 1.0))
+SCALAR(c_lognormal, lognormal(crandom, 0.0, 1.0))
+SCALAR(c_geometric, geometric(crandom, 0.7))
+SCALAR(c_poisson_05, Poisson(crandom, 0.5))
+SCALAR(c_poisson_5, Poisson(crandom, 5.0))
+SCALAR(c_poisson_50, Poisson(crandom, 50.0))
+SCALAR(c_poisson_500, Poisson(crandom, 500.0))
+SCALAR(c_binomial_10, binomial(crandom, 10, 0.3))
+SCALAR(c_binomial_1000, binomial(crandom, 1000, 0.3))
+SCALAR(c_chisquare, chisquare(crandom, 4))
+SCALAR(c_student, student(crandom, 5))
+
+static void c_uniform_fill(struct cRandom * crandom, double * array, size_t size) {
+  uniform_fill(crandom, 0.0, 1.0, array, size);
+}
+
+static void c_exponential_fill(struct cRandom * crandom, double * array, size_t size) {
+  exponential_fill(crandom, 1.0, array, size);
+}
+
+static void c_normal_fill(struct cRandom * crandom, double * array, size_t size) {
+  normal_fill(crandom, 0.0, 1.0, array, size);
+}
+
+STANDARD(s_uniform, std::uniform_real_distribution<double> d(0.0, 1.0))
+STANDARD(s_equilikely, std::uniform_int_distribution<int> d(1, 6))
+STANDARD(s_exponential, std::exponential_distribution<double> d(1.0))
+STANDARD(s_normal, std::normal_distribution<double> d(0.0, 1.0))
+STANDARD(s_lognormal, std::lognormal_distribution<double> d(0.0, 1.0))
+/* std::geometric_distribution counts failures with success probability p */
+STANDARD(s_geometric, std::geometric_distribution<int> d(0.3))
+STANDARD(s_poisson_05, std::poisson_distribution<int> d(0.5))
+STANDARD(s_poisson_5, std::poisson_distribution<int> d(5.0))
+STANDARD(s_poisson_50, std::poisson_distribution<int> d(50.0))
+STANDARD(s_poisson_500, std::poisson_distribution<int> d(500.0))
+STANDARD(s_binomial_10, std::binomial_distribution<int> d(10, 0.3))
+STANDARD(s_binomial_1000, std::binomial_distribution<int> d(1000, 0.3))
+STANDARD(s_chisquare, std::chi_squared_distribution<double> d(4.0))
+STANDARD(s_student, std::student_t_distribution<double> d(5.0))
+
+
+struct Case {
+  const char * name;
+  const char * params;
+  Generate crandom;
+  Generate standard;
+};
+
+
+static const struct Case cases[] = {
+  { "uniform",          "a=0,b=1",      &c_uniform,          &s_uniform },
+  { "uniform_fill",     "a=0,b=1",      &c_uniform_fill,     &s_uniform },
+  { "equilikely",       "a=1,b=6",      &c_equilikely,       &s_equilikely },
+  { "exponential",      "m=1",          &c_exponential,      &s_exponential },
+  { "exponential_fill", "m=1",          &c_exponential_fill, &s_exponential },
+  { "normal",           "m=0,s=1",      &c_normal,           &s_normal },
+  { "normal_fill",      "m=0,s=1",      &c_normal_fill,      &s_normal },
+  { "lognormal",        "a=0,b=1",      &c_lognormal,        &s_lognormal },
+  { "geometric",        "p=0.7",        &c_geometric,        &s_geometric },
+  { "Poisson",          "m=0.5",        &c_poisson_05,       &s_poisson_05 },
+  { "Poisson",          "m=5",          &c_poisson_5,        &s_poisson_5 },
+  { "Poisson",          "m=50",         &c_poisson_50,       &s_poisson_50 },
+  { "Poisson",          "m=500",        &c_poisson_500,      &s_poisson_500 },
+  { "binomial",         "n=10,p=0.3",   &c_binomial_10,      &s_binomial_10 },
+  { "binomial",         "n=1000,p=0.3", &c_binomial_1000,    &s_binomial_1000 },
+  { "chisquare",        "n=4",          &c_chisquare,        &s_chisquare },
+  { "student",          "n=5",          &c_student,          &s_student }
+};
+
+
+/**
+ * Returns the median ns/sample of repeats runs
+ */
+static double measure(Generate generate, struct cRandom * crandom, double * array, size_t samples, int repeats, double * seconds,
+                      struct BenchCounters * counters) {
+  for(int r = -1; r < repeats; ++r) {
+    if( r == 0 )
+      bench_counters_start(counters);
+
+    double start = bench_now(), sum = 0.0;
+
+    for(size_t done = 0; done < samples; done += BUFFER) {
+      generate(crandom, array, BUFFER);
+      sum += array[BUFFER - 1];
+    }
+    bench_sink = sum;
+
+    /* r = -1 is the warm up */
+    if( r >= 0 )
+      seconds[r] = bench_now() - start;
+  }
+  bench_counters_stop(counters);
+
+  return 1e9 * bench_median(seconds, repeats) / samples;
+}
+
+
+int main(int argc, char ** argv) {
+  const size_t samples = (argc > 1) ? (size_t) atof(argv[1]) : SAMPLES;
+  const int repeats = (argc > 2) ? atoi(argv[2]) : REPEATS;
+  const int pinned = bench_pin(0);
+  double array[BUFFER];
+  double * seconds = (double *) malloc(repeats * sizeof(double));
+  struct cRandom * crandom = dSFMTRandomNewBySeed(12345);
+  struct BenchCounters ours, theirs;
+  const int available = bench_counters_open(&ours);
+
+  bench_counters_open(&theirs);
+
+  if( seconds == NULL || crandom == NULL || repeats <= 0 )
+    return 1;
+
+  printf("{\n  \"benchmark\": \"baseline\",\n  \"samples\": %lu,\n  \"repeats\": %d,\n  \"pinned\": %s,\n"
+         "  \"counters_available\": %d,\n  \"crandom_engine\": \"dSFMT\",\n  \"standard_engine\": \"std::mt19937_64\",\n  \"results\": [",
+         (unsigned long) samples, repeats, pinned ? "true" : "false", available);
+
+  for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+    const double crandomNs = measure(cases[c].crandom, crandom, array, samples, repeats, seconds, &ours);
+    const double standardNs = measure(cases[c].standard, crandom, array, samples, repeats, seconds, &theirs);
+
+    printf("%s\n    {\"function\": ", c == 0 ? "" : ",");
+    bench_json_string(stdout, cases[c].name);
+    printf(", \"params\": ");
+    bench_json_string(stdout, cases[c].params);
+    printf(", \"crandom_ns\": %.3f, \"standard_ns\": %.3f, \"speedup\": %.3f", crandomNs, standardNs, standardNs / crandomNs);
+    printf(", \"crandom\": {");
+    bench_counters_json(stdout, &ours, (double) samples * repeats);
+    printf("}, \"standard\": {");
+    bench_counters_json(stdout, &theirs, (double) samples * repeats);
+    printf("}}");
+  }
+
+  printf("\n  ]\n}\n");
+
+  bench_counters_close(&ours);
+  bench_counters_close(&theirs);
+  crandom->release(crandom);
+  free(seconds);
+  return 0;
+}
@@ -0,0 +1,223 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+/*
+ * Event rate of the discrete-event simulation kernel (des.h): ns/event
+ * and events/s for every model and calendar size, as JSON on the
+ * standard output. The models:
+ *
+ *   - hold: the classic calendar benchmark; every event reschedules
+ *     itself exponential(1) later, so the calendar keeps "pending"
+ *     events and every event is one pop and one push;
+ *   - mm1: an M/M/1 queue (load 0.8, two entity streams) next to
+ *     "pending" far-future events that are never processed, i.e. a
+ *     small working set at the top of a large heap.
+ *
+ *   cc -O2 -DDSFMT_MEXP=19937 bench_des.c benchmark.c des.c crandom.c dSFMT/dSFMT.c -lm
+ *   ./a.out [events per repeat] [repeats] [model filter]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "des.h"
+
+
+#define EVENTS (1 << 22)
+#define REPEATS (5)
+
+/* Time beyond the end of every run */
+#define FOREVER (1e300)
+
+/* Time of the far-future events of mm1 */
+#define FAR (1e200)
+
+
+enum { EVENT_HOLD, EVENT_ARRIVAL, EVENT_DEPARTURE, EVENT_FAR };
+
+
+/**
+ * State of a run: the handler stops the run after limit events
+ */
+struct State {
+  size_t events;
+  size_t limit;
+  long queue;
+  int failed;
+};
+
+
+/**
+ * Model: setup fills the calendar, returns 0 if there is not enough memory
+ */
+struct Model {
+  const char * name;
+  int (* setup)(struct DesSimulation * sim, size_t pending);
+  DesHandler handler;
+};
+
+
+static void count(struct DesSimulation * sim, struct State * state) {
+  if( ++state->events >= state->limit )
+    DesStop(sim);
+}
+
+
+static void fail(struct DesSimulation * sim, struct State * state) {
+  state->failed = 1;
+  DesStop(sim);
+}
+
+
+static int setup_hold(struct DesSimulation * sim, size_t pending) {
+  struct cRandom * crandom = DesStream(sim, 0);
+  size_t i;
+
+  if( crandom == NULL )
+    return 0;
+  for(i = 0; i < pending; ++i) {
+    if( DesSchedule(sim, exponential(crandom, 1.0), EVENT_HOLD, 0, NULL) == NULL )
+      return 0;
+  }
+  return 1;
+}
+
+
+static void handle_hold(struct DesSimulation * sim, const struct DesEvent * event, void * ctx) {
+  struct State * state = (struct State *) ctx;
+  struct cRandom * crandom = DesStream(sim, 0);
+
+  if( crandom == NULL ||
+      DesSchedule(sim, event->time + exponential(crandom, 1.0), EVENT_HOLD, 0, NULL) == NULL ) {
+    fail(sim, state);
+    return;
+  }
+  count(sim, state);
+}
+
+
+static int setup_mm1(struct DesSimulation * sim, size_t pending) {
+  size_t i;
+
+  for(i = 0; i < pending; ++i) {
+    if( DesSchedule(sim, FAR + (double) i, EVENT_FAR, 0, NULL) == NULL )
+      return 0;
+  }
+  return DesSchedule(sim, DesNow(sim), EVENT_ARRIVAL, 0, NULL) != NULL;
+}
+
+
+static void handle_mm1(struct DesSimulation * sim, const struct DesEvent * event, void * ctx) {
+  struct State * state = (struct State *) ctx;
+  struct cRandom * arrivals = DesStream(sim, 0);
+  struct cRandom * service = DesStream(sim, 1);
+
+  if( arrivals == NULL || service == NULL ) {
+    fail(sim, state);
+    return;
+  }
+
+  if( event->type == EVENT_ARRIVAL ) {
+    if( DesSchedule(sim, event->time + exponential(arrivals, 1.0), EVENT_ARRIVAL, 0, NULL) == NULL ||
+        (state->queue++ == 0 &&
+         DesSchedule(sim, event->time + exponential(service, 0.8), EVENT_DEPARTURE, 1, NULL) == NULL) ) {
+      fail(sim, state);
+      return;
+    }
+  } else {
+    if( --state->queue > 0 &&
+        DesSchedule(sim, event->time + exponential(service, 0.8), EVENT_DEPARTURE, 1, NULL) == NULL ) {
+      fail(sim, state);
+      return;
+    }
+  }
+  count(sim, state);
+}
+
+
+static const struct Model models[] = {
+  { "hold", &setup_hold, &handle_hold },
+  { "mm1",  &setup_mm1,  &handle_mm1 }
+};
+
+
+/* Calendar sizes */
+static const size_t sizes[] = { 1, 1024, 65536, 1048576 };
+
+
+/**
+ * Processes events events, returns seconds or a negative value on failure
+ */
+static double run(struct DesSimulation * sim, struct State * state, size_t events) {
+  double start = bench_now();
+
+  state->events = 0;
+  state->limit = events;
+  DesRun(sim, FOREVER);
+  if( state->failed || state->events != events )
+    return -1.0;
+
+  return bench_now() - start;
+}
+
+
+int main(int argc, char ** argv) {
+  const size_t events = (argc > 1) ? (size_t) atof(argv[1]) : EVENTS;
+  const int repeats = (argc > 2) ? atoi(argv[2]) : REPEATS;
+  const char * filter = (argc > 3) ? argv[3] : NULL;
+  const int pinned = bench_pin(0);
+  double * seconds = (double *) malloc(repeats * sizeof(double));
+  struct DesSimulation * sim;
+  struct State state;
+  double median;
+  size_t m, s;
+  int r, first = 1;
+
+  if( seconds == NULL || repeats <= 0 || events == 0 )
+    return 1;
+
+  printf("{\n  \"benchmark\": \"des\",\n  \"events\": %lu,\n  \"repeats\": %d,\n  \"pinned\": %s,\n  \"results\": [",
+         (unsigned long) events, repeats, pinned ? "true" : "false");
+
+  for(m = 0; m < sizeof(models) / sizeof(models[0]); ++m) {
+    if( filter != NULL && strstr(models[m].name, filter) == NULL )
+      continue;
+
+    for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+      memset(&state, 0, sizeof(state));
+      sim = DesSimulationNew(2, 12345, models[m].handler, &state);
+      if( sim == NULL || !models[m].setup(sim, sizes[s]) )
+        return 1;
+
+      /* warm up: the event pool, caches, the clock frequency */
+      if( run(sim, &state, events / 4 + 1) < 0.0 )
+        return 1;
+      for(r = 0; r < repeats; ++r) {
+        seconds[r] = run(sim, &state, events);
+        if( seconds[r] < 0.0 )
+          return 1;
+      }
+
+      /* sorts seconds, so seconds[0] is the minimum */
+      median = bench_median(seconds, repeats);
+
+      printf("%s\n    {\"model\": ", first ? "" : ",");
+      bench_json_string(stdout, models[m].name);
+      printf(", \"pending\": %lu, \"ns_per_event\": %.2f, \"ns_per_event_min\": %.2f, \"events_per_second\": %.4g}",
+             (unsigned long) DesPending(sim), 1e9 * median / events, 1e9 * seconds[0] / events, events / median);
+      first = 0;
+
+      DesSimulationRelease(sim);
+    }
+  }
+
+  printf("\n  ]\n}\n");
+
+  free(seconds);
+  return 0;
+}
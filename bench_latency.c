@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+/*
+ * Per-call latency: every call is timed by the time stamp counter and
+ * the times go to an HDR histogram (1.6% resolution); p50, p99, p99.9
+ * and max are printed as JSON for every engine and mode. The tail shows
+ * the dsfmt_gen_rand_all refill that happens once per DSFMT_N64 values.
+ *
+ *   cc -O2 -DDSFMT_MEXP=19937 bench_latency.c benchmark.c crandom.c dSFMT/dSFMT.c -lm
+ *   ./a.out [calls]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "crandom.h"
+#include "dSFMT/dSFMT.h"
+
+
+#define CALLS (10000000)
+
+/* HDR histogram: values below 2 * SUB are exact, above that every power
+   of two is split into SUB buckets (up to 2^64 - 1) */
+#define SUB_BITS (6)
+#define SUB (1 << SUB_BITS)
+#define BUCKETS ((64 - SUB_BITS + 1) * SUB)
+
+/* Buffer of the buffered mode */
+#define BUFFER (1024)
+
+
+struct Engine {
+  const char * name;
+  struct cRandom * (* create)(int seed);
+};
+
+
+static const struct Engine engines[] = {
+  { "dSFMT", &dSFMTRandomNewBySeed }
+};
+
+
+/**
+ * Makes one call, returns its result
+ */
+typedef double (* Call)(struct cRandom * crandom);
+
+
+static double c_next(struct cRandom * crandom) {
+  return crandom->next(crandom);
+}
+
+
+static double c_uniform(struct cRandom * crandom) {
+  return uniform(crandom, -1.0, 1.0);
+}
+
+
+static double c_exponential(struct cRandom * crandom) {
+  return exponential(crandom, 1.0);
+}
+
+
+static double c_normal(struct cRandom * crandom) {
+  return normal(crandom, 0.0, 1.0);
+}
+
+
+static double c_poisson(struct cRandom * crandom) {
+  return Poisson(crandom, 5.0);
+}
+
+
+static double c_binomial(struct cRandom * crandom) {
+  return binomial(crandom, 10, 0.3);
+}
+
+
+/* buffered mode: values come from a buffer refilled by random_fill */
+static double buffer[BUFFER];
+static int position = BUFFER;
+
+static double c_buffered(struct cRandom * crandom) {
+  if( position == BUFFER ) {
+    random_fill(crandom, buffer, BUFFER);
+    position = 0;
+  }
+  return buffer[position++];
+}
+
+
+struct Mode {
+  const char * name;
+  const char * params;
+  Call call;
+};
+
+
+static const struct Mode modes[] = {
+  { "next",        "",           &c_next },
+  { "buffered",    "buffer=1024", &c_buffered },
+  { "uniform",     "a=-1,b=1",   &c_uniform },
+  { "exponential", "m=1",        &c_exponential },
+  { "normal",      "m=0,s=1",    &c_normal },
+  { "Poisson",     "m=5",        &c_poisson },
+  { "binomial",    "n=10,p=0.3", &c_binomial }
+};
+
+
+static int bucket(unsigned long long v) {
+  int shift = 0;
+
+  if( v < 2 * SUB )
+    return (int) v;
+  while( (v >> shift) >= 2 * SUB )
+    ++shift;
+  return (shift + 1) * SUB + (int) ((v >> shift) - SUB);
+}
+
+
+/**
+ * Returns the smallest value of bucket i
+ */
+static unsigned long long bucket_value(int i) {
+  if( i < 2 * SUB )
+    return i;
+  return (unsigned long long) (i % SUB + SUB) << (i / SUB - 1);
+}
+
+
+/**
+ * Returns the q-quantile of the histogram, in ticks
+ */
+static unsigned long long percentile(const unsigned long long * histogram, unsigned long long total, double q) {
+  unsigned long long rank = (unsigned long long) (q * total), sum = 0;
+  int i;
+
+  for(i = 0; i < BUCKETS; ++i) {
+    sum += histogram[i];
+    if( sum > rank )
+      return bucket_value(i);
+  }
+  return bucket_value(BUCKETS - 1);
+}
+
+
+/**
+ * Returns the smallest cost of an empty timed region
+ */
+static unsigned long long overhead(void) {
+  unsigned long long best = ~0ULL, t0, t1;
+  int i;
+
+  for(i = 0; i < 100000; ++i) {
+    t0 = bench_ticks();
+    t1 = bench_ticks();
+    if( t1 - t0 < best )
+      best = t1 - t0;
+  }
+  return best;
+}
+
+
+int main(int argc, char ** argv) {
+  const unsigned long long calls = (argc > 1) ? (unsigned long long) atof(argv[1]) : CALLS;
+  const int pinned = bench_pin(0);
+  const double ratio = bench_ticks_per_ns();
+  const unsigned long long empty = overhead();
+  unsigned long long * histogram = (unsigned long long *) malloc(BUCKETS * sizeof(unsigned long long));
+  unsigned long long i, t0, t1, dt, max;
+  size_t e, m;
+  double sum;
+  int first = 1;
+
+  if( histogram == NULL || calls == 0 )
+    return 1;
+
+  printf("{\n  \"benchmark\": \"latency\",\n  \"calls\": %llu,\n  \"pinned\": %s,\n  \"ticks_per_ns\": %.4f,\n"
+         "  \"timer_overhead_ticks\": %llu,\n  \"refill_period\": %d,\n  \"results\": [",
+         calls, pinned ? "true" : "false", ratio, empty, DSFMT_N64);
+
+  for(e = 0; e < sizeof(engines) / sizeof(engines[0]); ++e) {
+    for(m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+      struct cRandom * crandom = engines[e].create(12345);
+
+      if( crandom == NULL )
+        return 1;
+
+      memset(histogram, 0, BUCKETS * sizeof(unsigned long long));
+      position = BUFFER;
+      max = 0;
+      sum = 0.0;
+
+      /* warm up */
+      for(i = 0; i < calls / 10; ++i)
+        sum += modes[m].call(crandom);
+
+      for(i = 0; i < calls; ++i) {
+        t0 = bench_ticks();
+        sum += modes[m].call(crandom);
+        t1 = bench_ticks();
+
+        /* a clock read going backwards (migration, unsynchronized TSCs)
+           counts as 0 rather than as a wrapped 2^64 */
+        dt = (t1 > t0 && t1 - t0 > empty) ? t1 - t0 - empty : 0;
+        histogram[bucket(dt)]++;
+        if( dt > max )
+          max = dt;
+      }
+      bench_sink = sum;
+      crandom->release(crandom);
+
+      printf("%s\n    {\"engine\": ", first ? "" : ",");
+      bench_json_string(stdout, engines[e].name);
+      printf(", \"mode\": ");
+      bench_json_string(stdout, modes[m].name);
+      printf(", \"params\": ");
+      bench_json_string(stdout, modes[m].params);
+      printf(", \"p50_ns\": %.1f, \"p99_ns\": %.1f, \"p99.9_ns\": %.1f, \"p99.99_ns\": %.1f, \"max_ns\": %.1f}",
+             percentile(histogram, calls, 0.5) / ratio, percentile(histogram, calls, 0.99) / ratio,
+             percentile(histogram, calls, 0.999) / ratio, percentile(histogram, calls, 0.9999) / ratio, max / ratio);
+      first = 0;
+    }
+  }
+
+  printf("\n  ]\n}\n");
+
+  free(histogram);
+  return 0;
+}
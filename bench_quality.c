@@ -0,0 +1,611 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+/*
+ * Statistical-quality gate: for every sampler of crandom.h, scalar and
+ * batch forms, compares samples samples with the exact distribution:
+ *
+ *   - chi-square on 1024 equiprobable cells of the probability integral
+ *     transform (continuous) or on the pooled probability mass (discrete);
+ *   - Kolmogorov-Smirnov and Anderson-Darling on a grid of 65536 cells
+ *     of the probability integral transform (continuous);
+ *   - z-tests of the mean and of the variance (when the fourth moment
+ *     exists).
+ *
+ * Samples are generated in parallel by crandom_parallel_histogram and
+ * crandom_parallel_moments; the generation throughput is reported next
+ * to the verdict. A test fails when its p-value is below 1e-4. Run the
+ * gate for every build variant (e.g. with and without HAVE_SSE2).
+ *
+ * The regression checks that follow run deterministic scenarios of past
+ * bugs (e.g. a reaction network run to absorption).
+ *
+ *   cc -O2 -DDSFMT_MEXP=19937 bench_quality.c benchmark.c crandom.c jump.c histogram.c \
+ *      moments.c quantile.c parallel.c gillespie.c copula.c dSFMT/dSFMT.c -lm -pthread
+ *   ./a.out [samples] [threads]
+ *
+ * The exit status is 1 if any test fails.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "copula.h"
+#include "crandom.h"
+#include "gillespie.h"
+#include "parallel.h"
+
+
+#define SAMPLES (100000000)
+
+/* Cells of the continuous grid and of the chi-square */
+#define GRID (65536)
+#define CELLS (1024)
+
+/* Smallest expected count of a discrete chi-square cell */
+#define POOL (20.0)
+
+/* Largest value of a discrete distribution counted on its own */
+#define SUPPORT (4096)
+
+/* p-values below it fail */
+#define ALPHA (1e-4)
+
+#define E (2.718281828459045)
+
+
+typedef void (* Generate)(struct cRandom * crandom, double * array, size_t size);
+
+
+struct Test {
+  const char * name;
+  const char * form;
+  const char * params;
+  Generate generate;
+
+  /* exactly one of them: the CDF or the probability mass */
+  double (* cdf)(double x);
+  double (* pmf)(int k);
+
+  /* mean, variance and the fourth central moment; variance < 0 skips */
+  double mean;
+  double variance;
+  double mu4;
+};
+
+
+#define SCALAR(fn, call)                                                  \
+  static void fn(struct cRandom * crandom, double * array, size_t size) { \
+    size_t i;                                                             \
+    for(i = 0; i < size; ++i)                                             \
+      array[i] = (double) (call);                                         \
+  }
+
+SCALAR(s_bernoulli, bernoulli(crandom, 0.3))
+SCALAR(s_binomial, binomial(crandom, 10, 0.3))
+SCALAR(s_equilikely, equilikely(crandom, 1, 6))
+SCALAR(s_geometric, geometric(crandom, 0.7))
+SCALAR(s_pascal, pascal(crandom, 5, 0.5))
+SCALAR(s_poisson_3, Poisson(crandom, 3.0))
+SCALAR(s_poisson_30, Poisson(crandom, 30.0))
+SCALAR(s_next, crandom->next(crandom))
+SCALAR(s_uniform, uniform(crandom, -1.0, 1.0))
+SCALAR(s_exponential, exponential(crandom, 1.0))
+SCALAR(s_erlang, erlang(crandom, 3, 1.0))
+SCALAR(s_normal, normal(crandom, 0.0, 1.0))
+SCALAR(s_lognormal, lognormal(crandom, 0.0, 1.0))
+SCALAR(s_chisquare, chisquare(crandom, 4))
+SCALAR(s_student, student(crandom, 2))
+SCALAR(s_power_law, power_law(crandom, -2.5, 1.0))
+
+
+static void b_random(struct cRandom * crandom, double * array, size_t size) {
+  random_fill(crandom, array, size);
+}
+
+
+static void b_uniform(struct cRandom * crandom, double * array, size_t size) {
+  uniform_fill(crandom, -1.0, 1.0, array, size);
+}
+
+
+static void b_exponential(struct cRandom * crandom, double * array, size_t size) {
+  exponential_fill(crandom, 1.0, array, size);
+}
+
+
+static void b_normal(struct cRandom * crandom, double * array, size_t size) {
+  normal_fill(crandom, 0.0, 1.0, array, size);
+}
+
+
+/*
+ * One-dimensional copulas with gamma marginals; a GaussianCopula object
+ * must not be shared between threads, so every thread builds its own.
+ */
+#define COPULAS (2)
+
+static const struct CopulaMarginal copulaMarginals[COPULAS] = {
+  { COPULA_GAMMA, 1.0, 1.0, NULL, 0 },
+  { COPULA_GAMMA, 3.0, 1.0, NULL, 0 }
+};
+
+static pthread_key_t copulaKeys[COPULAS];
+
+
+static void copula_release(void * copula) {
+  GaussianCopulaRelease((struct GaussianCopula *) copula);
+}
+
+
+static void copula_fill(int c, struct cRandom * crandom, double * array, size_t size) {
+  struct GaussianCopula * copula = (struct GaussianCopula *) pthread_getspecific(copulaKeys[c]);
+  const double one = 1.0;
+
+  if( copula == NULL ) {
+    copula = GaussianCopulaNew(1, &one, &copulaMarginals[c]);
+    if( copula == NULL || pthread_setspecific(copulaKeys[c], copula) != 0 )
+      exit(1);
+  }
+  GaussianCopulaFill(copula, crandom, array, size);
+}
+
+
+static void b_copula_gamma_1(struct cRandom * crandom, double * array, size_t size) {
+  copula_fill(0, crandom, array, size);
+}
+
+
+static void b_copula_gamma_3(struct cRandom * crandom, double * array, size_t size) {
+  copula_fill(1, crandom, array, size);
+}
+
+
+/*
+ * C89 has neither lgamma nor erfc: log_gamma is the Lanczos series of
+ * copula.c, the normal cdf is normal_cdf_fill of copula.h.
+ */
+
+/**
+ * Returns log(Gamma(x)), x > 0 (Lanczos, absolute error below 2e-10)
+ */
+static double log_gamma(double x) {
+  static const double c[6] = {
+    76.18009172947146, -86.50532032941677, 24.01409824083091,
+    -1.231739572450155, 0.1208650973866179e-2, -0.5395239384953e-5
+  };
+  double y = x, t, s = 1.000000000190015;
+  int i;
+
+  t = x + 5.5;
+  t -= (x + 0.5) * log(t);
+  for(i = 0; i < 6; ++i)
+    s += c[i] / ++y;
+  return -t + log(2.5066282746310005 * s / x);
+}
+
+
+static double normal_cdf(double x) {
+  normal_cdf_fill(&x, 1);
+  return x;
+}
+
+
+/* Exact distributions */
+
+static double choose(int n, int k) {
+  return exp(log_gamma(n + 1.0) - log_gamma(k + 1.0) - log_gamma(n - k + 1.0));
+}
+
+static double pmf_bernoulli(int k) { return (k == 0) ? 0.7 : (k == 1) ? 0.3 : 0.0; }
+static double pmf_binomial(int k) { return (k <= 10) ? choose(10, k) * pow(0.3, k) * pow(0.7, 10 - k) : 0.0; }
+static double pmf_equilikely(int k) { return (1 <= k && k <= 6) ? 1.0 / 6.0 : 0.0; }
+static double pmf_geometric(int k) { return 0.3 * pow(0.7, k); }
+static double pmf_pascal(int k) { return choose(k + 4, k) * pow(0.5, k) * pow(0.5, 5); }
+static double pmf_poisson_3(int k) { return exp(k * log(3.0) - 3.0 - log_gamma(k + 1.0)); }
+static double pmf_poisson_30(int k) { return exp(k * log(30.0) - 30.0 - log_gamma(k + 1.0)); }
+
+static double cdf_next(double x) { return x; }
+static double cdf_uniform(double x) { return (x + 1.0) / 2.0; }
+static double cdf_exponential(double x) { return 1.0 - exp(-x); }
+static double cdf_erlang(double x) { return 1.0 - exp(-x) * (1.0 + x + x * x / 2.0); }
+static double cdf_normal(double x) { return normal_cdf(x); }
+static double cdf_lognormal(double x) { return cdf_normal(log(x)); }
+static double cdf_chisquare(double x) { return 1.0 - exp(-x / 2.0) * (1.0 + x / 2.0); }
+static double cdf_student(double x) { return 0.5 + x / (2.0 * sqrt(2.0 + x * x)); }
+static double cdf_power_law(double x) { return 1.0 - pow(x, 1.0 / -1.5) / 1.5; }
+
+
+/* kurtosis of the negative binomial with r successes and failure probability p */
+#define NB_MU4(r, p) ((3.0 + 6.0 / (r) + (1.0 - (p)) * (1.0 - (p)) / ((r) * (p))) * \
+                      ((r) * (p) / ((1.0 - (p)) * (1.0 - (p)))) * ((r) * (p) / ((1.0 - (p)) * (1.0 - (p)))))
+
+static const struct Test tests[] = {
+  { "bernoulli",   "scalar", "p=0.3",      &s_bernoulli,   NULL, &pmf_bernoulli,   0.3, 0.21, 0.21 * 0.37 },
+  { "binomial",    "scalar", "n=10,p=0.3", &s_binomial,    NULL, &pmf_binomial,    3.0, 2.1, 2.1 * (1.0 + 3.0 * 8.0 * 0.21) },
+  { "equilikely",  "scalar", "a=1,b=6",    &s_equilikely,  NULL, &pmf_equilikely,  3.5, 35.0 / 12.0, 101.0 * 35.0 / 240.0 },
+  { "geometric",   "scalar", "p=0.7",      &s_geometric,   NULL, &pmf_geometric,   0.7 / 0.3, 0.7 / 0.09, NB_MU4(1.0, 0.7) },
+  { "pascal",      "scalar", "n=5,p=0.5",  &s_pascal,      NULL, &pmf_pascal,      5.0, 10.0, NB_MU4(5.0, 0.5) },
+  { "Poisson",     "scalar", "m=3",        &s_poisson_3,   NULL, &pmf_poisson_3,   3.0, 3.0, 3.0 + 27.0 },
+  { "Poisson",     "scalar", "m=30",       &s_poisson_30,  NULL, &pmf_poisson_30,  30.0, 30.0, 30.0 + 2700.0 },
+  { "next",        "scalar", "",           &s_next,        &cdf_next, NULL,        0.5, 1.0 / 12.0, 1.0 / 80.0 },
+  { "uniform",     "scalar", "a=-1,b=1",   &s_uniform,     &cdf_uniform, NULL,     0.0, 1.0 / 3.0, 1.0 / 5.0 },
+  { "exponential", "scalar", "m=1",        &s_exponential, &cdf_exponential, NULL, 1.0, 1.0, 9.0 },
+  { "erlang",      "scalar", "n=3,b=1",    &s_erlang,      &cdf_erlang, NULL,      3.0, 3.0, 45.0 },
+  { "normal",      "scalar", "m=0,s=1",    &s_normal,      &cdf_normal, NULL,      0.0, 1.0, 3.0 },
+  { "lognormal",   "scalar", "a=0,b=1",    &s_lognormal,   &cdf_lognormal, NULL,   1.6487212707001282, (E - 1.0) * E,
+    (E * E * E * E + 2.0 * E * E * E + 3.0 * E * E - 3.0) * (E - 1.0) * E * (E - 1.0) * E },
+  { "chisquare",   "scalar", "n=4",        &s_chisquare,   &cdf_chisquare, NULL,   4.0, 8.0, 384.0 },
+  { "student",     "scalar", "n=2",        &s_student,     &cdf_student, NULL,     0.0, -1.0, 0.0 },
+  { "power_law",   "scalar", "k=-2.5,c=1", &s_power_law,   &cdf_power_law, NULL,   0.0, -1.0, 0.0 },
+  { "random_fill",      "batch", "",         &b_random,      &cdf_next, NULL,        0.5, 1.0 / 12.0, 1.0 / 80.0 },
+  { "uniform_fill",     "batch", "a=-1,b=1", &b_uniform,     &cdf_uniform, NULL,     0.0, 1.0 / 3.0, 1.0 / 5.0 },
+  { "exponential_fill", "batch", "m=1",      &b_exponential, &cdf_exponential, NULL, 1.0, 1.0, 9.0 },
+  { "normal_fill",      "batch", "m=0,s=1",  &b_normal,      &cdf_normal, NULL,      0.0, 1.0, 3.0 },
+  { "GaussianCopulaFill", "batch", "gamma,a=1,b=1", &b_copula_gamma_1, &cdf_exponential, NULL, 1.0, 1.0, 9.0 },
+  { "GaussianCopulaFill", "batch", "gamma,a=3,b=1", &b_copula_gamma_3, &cdf_erlang, NULL,      3.0, 3.0, 45.0 }
+};
+
+
+/* Samplers of crandom_parallel_* */
+
+static void sample(void * ctx, struct cRandom * crandom, double * array, size_t size) {
+  ((const struct Test *) ctx)->generate(crandom, array, size);
+}
+
+
+static void sample_transformed(void * ctx, struct cRandom * crandom, double * array, size_t size) {
+  const struct Test * test = (const struct Test *) ctx;
+  size_t i;
+
+  test->generate(crandom, array, size);
+  for(i = 0; i < size; ++i)
+    array[i] = test->cdf(array[i]);
+}
+
+
+/* p-values */
+
+/**
+ * Returns the regularized upper incomplete gamma function Q(a, x)
+ */
+static double gamma_q(double a, double x) {
+  double sum, term, b, c, d, h, an;
+  int n;
+
+  if( x <= 0.0 )
+    return 1.0;
+
+  if( x < a + 1.0 ) {
+    /* series of P(a, x) */
+    sum = term = 1.0 / a;
+    for(n = 1; n < 100000 && fabs(term) > fabs(sum) * 1e-16; ++n) {
+      term *= x / (a + n);
+      sum += term;
+    }
+    return 1.0 - sum * exp(-x + a * log(x) - log_gamma(a));
+  }
+
+  /* continued fraction of Q(a, x) (modified Lentz) */
+  b = x + 1.0 - a;
+  c = 1e300;
+  d = 1.0 / b;
+  h = d;
+  for(n = 1; n < 100000; ++n) {
+    an = -n * (n - a);
+    b += 2.0;
+    d = an * d + b;
+    if( fabs(d) < 1e-300 )
+      d = 1e-300;
+    c = b + an / c;
+    if( fabs(c) < 1e-300 )
+      c = 1e-300;
+    d = 1.0 / d;
+    h *= d * c;
+    if( fabs(d * c - 1.0) < 1e-16 )
+      break;
+  }
+  return exp(-x + a * log(x) - log_gamma(a)) * h;
+}
+
+
+static double chi2_p(double statistic, int dof) {
+  return gamma_q(dof / 2.0, statistic / 2.0);
+}
+
+
+/**
+ * Kolmogorov distribution: P(sqrt(n) D > t) (Stephens' correction)
+ */
+static double ks_p(double d, double n) {
+  const double t = (sqrt(n) + 0.12 + 0.11 / sqrt(n)) * d;
+  double sum = 0.0, term;
+  int k;
+
+  if( t < 0.2 )
+    return 1.0;
+  for(k = 1; k < 100; ++k) {
+    term = 2.0 * ((k % 2) ? 1.0 : -1.0) * exp(-2.0 * k * k * t * t);
+    sum += term;
+    if( fabs(term) < 1e-16 )
+      break;
+  }
+  return (sum < 0.0) ? 0.0 : (sum > 1.0) ? 1.0 : sum;
+}
+
+
+/**
+ * Anderson-Darling, asymptotic distribution (Marsaglia and Marsaglia)
+ */
+static double ad_p(double z) {
+  double cdf;
+
+  if( z <= 0.0 )
+    return 1.0;
+  if( z < 2.0 )
+    cdf = exp(-1.2337141 / z) / sqrt(z) * (2.00012 + (0.247105 - (0.0649821 - (0.0347962 - (0.011672 - 0.00168691 * z) * z) * z) * z) * z);
+  else
+    cdf = exp(-exp(1.0776 - (2.30695 - (0.43424 - (0.082433 - (0.008056 - 0.0003146 * z) * z) * z) * z) * z));
+  return 1.0 - cdf;
+}
+
+
+static double z_p(double z) {
+  return 2.0 * normal_cdf(-fabs(z));
+}
+
+
+/**
+ * Result of one sampler
+ */
+struct Result {
+  double seconds;
+  double chi2, chi2P;
+  int dof;
+  double ks, ksP;
+  double ad, adP;
+  double meanZ, varianceZ;
+  int pass;
+};
+
+
+static void test_continuous(const struct Test * test, size_t samples, int threads, struct Result * result) {
+  struct Histogram * histogram = HistogramNew(GRID, 0.0, 1.0);
+  const double n = (double) samples, expected = n / CELLS;
+  double cumulative = 0.0, f, e, cell = 0.0, x;
+  int i;
+
+  if( histogram == NULL || !crandom_parallel_histogram(histogram, samples, &sample_transformed, (void *) test, 1, threads) )
+    exit(1);
+
+  result->chi2 = result->ks = result->ad = 0.0;
+  for(i = 0; i < GRID; ++i) {
+    x = (double) HistogramCount(histogram, i);
+    /* u = 1 goes to the extra cell */
+    if( i == GRID - 1 )
+      x += (double) HistogramCount(histogram, GRID);
+
+    cell += x;
+    if( (i + 1) % (GRID / CELLS) == 0 ) {
+      result->chi2 += (cell - expected) * (cell - expected) / expected;
+      cell = 0.0;
+    }
+
+    cumulative += x;
+    e = (i + 1.0) / GRID;
+    f = cumulative / n;
+    if( fabs(f - e) > result->ks )
+      result->ks = fabs(f - e);
+    if( i + 1 < GRID )
+      result->ad += (f - e) * (f - e) / (e * (1.0 - e)) / GRID;
+  }
+  result->ad *= n;
+
+  result->dof = CELLS - 1;
+  result->chi2P = chi2_p(result->chi2, result->dof);
+  result->ksP = ks_p(result->ks, n);
+  result->adP = ad_p(result->ad);
+
+  HistogramRelease(histogram);
+}
+
+
+static void test_discrete(const struct Test * test, size_t samples, int threads, struct Result * result) {
+  struct Histogram * histogram = HistogramNew(SUPPORT, -0.5, SUPPORT - 0.5);
+  const double n = (double) samples;
+  double observed = 0.0, expected = 0.0, rest = 1.0, p;
+  int k;
+
+  if( histogram == NULL || !crandom_parallel_histogram(histogram, samples, &sample, (void *) test, 1, threads) )
+    exit(1);
+
+  /* cells are pooled until the expected count is at least POOL; the
+     tail k >= SUPPORT is the extra cell of the histogram */
+  result->chi2 = 0.0;
+  result->dof = -1;
+  for(k = 0; k <= SUPPORT; ++k) {
+    p = (k < SUPPORT) ? test->pmf(k) : rest;
+    rest -= p;
+    observed += (double) HistogramCount(histogram, k);
+    expected += n * p;
+    if( expected >= POOL && n * rest >= POOL ) {
+      result->chi2 += (observed - expected) * (observed - expected) / expected;
+      result->dof++;
+      observed = expected = 0.0;
+    }
+  }
+  /* the last cell takes everything left */
+  expected += n * (rest > 0.0 ? rest : 0.0);
+  if( expected > 0.0 ) {
+    result->chi2 += (observed - expected) * (observed - expected) / expected;
+    result->dof++;
+  } else if( observed > 0.0 ) {
+    result->chi2 = HUGE_VAL;
+  }
+
+  result->chi2P = (result->dof > 0) ? chi2_p(result->chi2, result->dof) : 1.0;
+  result->ks = result->ad = 0.0;
+  result->ksP = result->adP = 1.0;
+
+  HistogramRelease(histogram);
+}
+
+
+/* Regression checks */
+
+/* Runs of the absorption check */
+#define ABSORPTION_RUNS (16)
+
+/**
+ * Runs the chain x[i] -> x[i + 1] (i = 0, ..., 4) with uneven rates from
+ * 300/200/100 molecules to the absorbing state: the incremental total
+ * propensity keeps a rounding residue there, which once made
+ * GillespieStep loop forever. Returns 1 if every run stops in the
+ * absorbing state after 2600 events without advancing the time.
+ */
+static int check_gillespie_absorption(void) {
+  static const double rates[5] = { 0.5, 1.5, 0.7, 2.3, 0.9 };
+  static const long initial[6] = { 300, 200, 100, 0, 0, 0 };
+  struct SsaTerm terms[6];
+  struct SsaReaction reactions[5];
+  struct Gillespie * ssa;
+  struct cRandom * crandom;
+  double time;
+  size_t events;
+  int i, run, ok = 1;
+
+  for(i = 0; i < 6; ++i) {
+    terms[i].species = i;
+    terms[i].count = 1;
+  }
+  for(i = 0; i < 5; ++i) {
+    reactions[i].rate = rates[i];
+    reactions[i].reactantCount = 1;
+    reactions[i].reactants = &terms[i];
+    reactions[i].productCount = 1;
+    reactions[i].products = &terms[i + 1];
+  }
+
+  for(run = 1; run <= ABSORPTION_RUNS && ok; ++run) {
+    crandom = dSFMTRandomNewBySeed(run);
+    ssa = GillespieNew(6, 5, reactions, initial);
+    if( crandom == NULL || ssa == NULL )
+      exit(1);
+
+    /* odd runs step, even runs call GillespieRun */
+    if( run % 2 ) {
+      for(events = 0; (i = GillespieStep(ssa, crandom)) >= 0; ++events)
+        ;
+      ok = (i == -1);
+    } else {
+      events = GillespieRun(ssa, crandom, 1e6);
+      ok = (GillespieTime(ssa) == 1e6);
+    }
+
+    time = GillespieTime(ssa);
+    ok = ok && events == 2600 && GillespieState(ssa)[5] == 600 &&
+         GillespieStep(ssa, crandom) == -1 && GillespieTime(ssa) == time;
+
+    GillespieRelease(ssa);
+    crandom->release(crandom);
+  }
+
+  return ok;
+}
+
+
+/**
+ * Regression check
+ */
+struct Check {
+  const char * name;
+  const char * params;
+  int (* run)(void);
+};
+
+
+static const struct Check checks[] = {
+  { "GillespieStep", "absorption", &check_gillespie_absorption }
+};
+
+
+int main(int argc, char ** argv) {
+  const size_t samples = (argc > 1) ? (size_t) atof(argv[1]) : SAMPLES;
+  const int threads = (argc > 2) ? atoi(argv[2]) : 0;
+  struct Result result;
+  struct Moments moments;
+  size_t t;
+  int failed = 0, c;
+  double start;
+
+  for(c = 0; c < COPULAS; ++c) {
+    if( pthread_key_create(&copulaKeys[c], &copula_release) != 0 )
+      return 1;
+  }
+
+  printf("{\n  \"benchmark\": \"quality\",\n  \"samples\": %lu,\n  \"threads\": %d,\n  \"alpha\": %g,\n  \"results\": [",
+         (unsigned long) samples, threads > 0 ? threads : crandom_thread_count(), ALPHA);
+
+  for(t = 0; t < sizeof(tests) / sizeof(tests[0]); ++t) {
+    const struct Test * test = &tests[t];
+
+    start = bench_now();
+    if( test->cdf != NULL )
+      test_continuous(test, samples, threads, &result);
+    else
+      test_discrete(test, samples, threads, &result);
+    result.seconds = bench_now() - start;
+
+    moments_init(&moments, 0);
+    if( !crandom_parallel_moments(&moments, samples, &sample, (void *) test, 2, threads) )
+      return 1;
+    result.meanZ = result.varianceZ = 0.0;
+    if( test->variance >= 0.0 ) {
+      result.meanZ = (moments_mean(&moments) - test->mean) / sqrt(test->variance / moments.n);
+      result.varianceZ = (moments_variance(&moments) - test->variance) / sqrt((test->mu4 - test->variance * test->variance) / moments.n);
+    }
+
+    result.pass = result.chi2P >= ALPHA && result.ksP >= ALPHA && result.adP >= ALPHA &&
+                  z_p(result.meanZ) >= ALPHA && z_p(result.varianceZ) >= ALPHA;
+    if( !result.pass )
+      failed = 1;
+
+    printf("%s\n    {\"function\": ", t == 0 ? "" : ",");
+    bench_json_string(stdout, test->name);
+    printf(", \"form\": ");
+    bench_json_string(stdout, test->form);
+    printf(", \"params\": ");
+    bench_json_string(stdout, test->params);
+    printf(", \"samples_per_second\": %.4g", samples / result.seconds);
+    printf(", \"chi2\": %.2f, \"dof\": %d, \"chi2_p\": %.4g", result.chi2, result.dof, result.chi2P);
+    if( test->cdf != NULL )
+      printf(", \"ks\": %.3g, \"ks_p\": %.4g, \"ad\": %.3f, \"ad_p\": %.4g", result.ks, result.ksP, result.ad, result.adP);
+    if( test->variance >= 0.0 )
+      printf(", \"mean_z\": %.3f, \"variance_z\": %.3f", result.meanZ, result.varianceZ);
+    printf(", \"pass\": %s}", result.pass ? "true" : "false");
+  }
+
+  for(t = 0; t < sizeof(checks) / sizeof(checks[0]); ++t) {
+    start = bench_now();
+    result.pass = checks[t].run();
+    result.seconds = bench_now() - start;
+    if( !result.pass )
+      failed = 1;
+
+    printf(",\n    {\"function\": ");
+    bench_json_string(stdout, checks[t].name);
+    printf(", \"form\": \"check\", \"params\": ");
+    bench_json_string(stdout, checks[t].params);
+    printf(", \"seconds\": %.3g, \"pass\": %s}", result.seconds, result.pass ? "true" : "false");
+  }
+
+  printf("\n  ],\n  \"pass\": %s\n}\n", failed ? "false" : "true");
+
+  return failed;
+}
@@ -0,0 +1,267 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+/*
+ * Multi-core scaling: sweeps 1..N threads (thread i pinned to processor
+ * i) and reports samples/s and the parallel efficiency rate(t) / (t *
+ * rate(1)) of
+ *
+ *   - private_padded: per-thread generators, each on its own cache lines;
+ *   - private_packed: the same generators packed back to back, so the
+ *     index of one and the state of the next share a cache line;
+ *   - private_crandom: per-thread dSFMTRandomNewBySeed objects with
+ *     normal_fill into a private buffer;
+ *   - construction: dSFMTRandomNewBySeed / release in a loop (allocator
+ *     and seeding cost);
+ *   - shared_fill: one crandom_parallel_fill of a large array (memory
+ *     bandwidth).
+ *
+ * The private scenarios do the same work per thread (weak scaling), the
+ * shared fill splits a fixed array (strong scaling). JSON goes to the
+ * standard output.
+ *
+ *   cc -O2 -DDSFMT_MEXP=19937 bench_scaling.c benchmark.c crandom.c jump.c histogram.c \
+ *      moments.c quantile.c parallel.c dSFMT/dSFMT.c -lm -pthread
+ *   ./a.out [max threads] [samples per thread] [shared fill size]
+ */
+
+/* pthread_barrier_t and posix_memalign */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "crandom.h"
+#include "dSFMT/dSFMT.h"
+#include "parallel.h"
+
+
+#define SAMPLES (1 << 25)
+#define FILL (1 << 24)
+#define BUFFER (1024)
+#define CONSTRUCTIONS (1 << 14)
+#define CACHE_LINE (64)
+
+
+/**
+ * Generator on its own cache lines
+ */
+struct Padded {
+  char before[CACHE_LINE];
+  dsfmt_t dsfmt;
+  char after[CACHE_LINE];
+};
+
+
+struct Thread {
+  pthread_t thread;
+  int index;
+  struct Scenario * scenario;
+
+  double start;
+  double end;
+};
+
+
+struct Scenario {
+  const char * name;
+  void (* run)(struct Thread * self, size_t samples);
+  size_t samples;
+  int threads;
+  pthread_barrier_t barrier;
+
+  dsfmt_t * packed;
+  struct Padded * padded;
+};
+
+
+static void run_packed(struct Thread * self, size_t samples) {
+  dsfmt_t * dsfmt = &self->scenario->packed[self->index];
+  double sum = 0.0;
+  size_t i;
+
+  for(i = 0; i < samples; ++i)
+    sum += dsfmt_genrand_close_open(dsfmt);
+  bench_sink = sum;
+}
+
+
+static void run_padded(struct Thread * self, size_t samples) {
+  dsfmt_t * dsfmt = &self->scenario->padded[self->index].dsfmt;
+  double sum = 0.0;
+  size_t i;
+
+  for(i = 0; i < samples; ++i)
+    sum += dsfmt_genrand_close_open(dsfmt);
+  bench_sink = sum;
+}
+
+
+static void run_crandom(struct Thread * self, size_t samples) {
+  struct cRandom * crandom = dSFMTRandomNewBySeed(self->index + 1);
+  double buffer[BUFFER], sum = 0.0;
+  size_t done;
+
+  if( crandom == NULL )
+    exit(1);
+  for(done = 0; done < samples; done += BUFFER) {
+    normal_fill(crandom, 0.0, 1.0, buffer, BUFFER);
+    sum += buffer[BUFFER - 1];
+  }
+  bench_sink = sum;
+  crandom->release(crandom);
+}
+
+
+static void run_construction(struct Thread * self, size_t samples) {
+  double sum = 0.0;
+  size_t i;
+
+  for(i = 0; i < samples; ++i) {
+    struct cRandom * crandom = dSFMTRandomNewBySeed((int) i);
+
+    if( crandom == NULL )
+      exit(1);
+    sum += crandom->next(crandom);
+    crandom->release(crandom);
+  }
+  bench_sink = sum;
+  (void) self;
+}
+
+
+static void * work(void * argument) {
+  struct Thread * self = (struct Thread *) argument;
+
+  bench_pin(self->index);
+  pthread_barrier_wait(&self->scenario->barrier);
+  self->start = bench_now();
+  self->scenario->run(self, self->scenario->samples);
+  self->end = bench_now();
+
+  return NULL;
+}
+
+
+/**
+ * Returns samples/s of all threads together
+ */
+static double measure(struct Scenario * scenario, int threads) {
+  struct Thread * workers = (struct Thread *) calloc(threads, sizeof(struct Thread));
+  double start, end;
+  int i;
+
+  if( workers == NULL )
+    exit(1);
+
+  scenario->threads = threads;
+  pthread_barrier_init(&scenario->barrier, NULL, threads);
+  for(i = 0; i < threads; ++i) {
+    workers[i].index = i;
+    workers[i].scenario = scenario;
+    if( pthread_create(&workers[i].thread, NULL, &work, &workers[i]) != 0 )
+      exit(1);
+  }
+  for(i = 0; i < threads; ++i)
+    pthread_join(workers[i].thread, NULL);
+  pthread_barrier_destroy(&scenario->barrier);
+
+  start = workers[0].start;
+  end = workers[0].end;
+  for(i = 1; i < threads; ++i) {
+    if( workers[i].start < start )
+      start = workers[i].start;
+    if( workers[i].end > end )
+      end = workers[i].end;
+  }
+
+  free(workers);
+  return (double) scenario->samples * threads / (end - start);
+}
+
+
+static void report(const char * name, int threads, double rate, double single, int * first) {
+  printf("%s\n    {\"scenario\": ", *first ? "" : ",");
+  bench_json_string(stdout, name);
+  printf(", \"threads\": %d, \"samples_per_second\": %.4g, \"efficiency\": %.3f}", threads, rate, rate / (threads * single));
+  *first = 0;
+}
+
+
+int main(int argc, char ** argv) {
+  const int maxThreads = (argc > 1 && atoi(argv[1]) > 0) ? atoi(argv[1]) : crandom_thread_count();
+  const size_t samples = (argc > 2) ? (size_t) atof(argv[2]) : SAMPLES;
+  const size_t fill = (argc > 3) ? (size_t) atof(argv[3]) : FILL;
+  struct Scenario scenarios[4];
+  struct cRandom * crandom = dSFMTRandomNewBySeed(1);
+  double * array = (double *) malloc(fill * sizeof(double));
+  double rate, single = 0.0, start;
+  int s, t, first = 1;
+  dsfmt_t * packed;
+  void * padded = NULL;
+
+  scenarios[0].name = "private_padded";
+  scenarios[0].run = &run_padded;
+  scenarios[1].name = "private_packed";
+  scenarios[1].run = &run_packed;
+  scenarios[2].name = "private_crandom";
+  scenarios[2].run = &run_crandom;
+  scenarios[3].name = "construction";
+  scenarios[3].run = &run_construction;
+
+  packed = (dsfmt_t *) calloc(maxThreads, sizeof(dsfmt_t));
+  if( posix_memalign(&padded, CACHE_LINE, maxThreads * sizeof(struct Padded)) != 0 )
+    return 1;
+  if( packed == NULL || crandom == NULL || array == NULL )
+    return 1;
+
+  for(t = 0; t < maxThreads; ++t) {
+    dsfmt_init_gen_rand(&packed[t], t + 1);
+    dsfmt_init_gen_rand(&((struct Padded *) padded)[t].dsfmt, t + 1);
+  }
+  for(s = 0; s < 4; ++s) {
+    scenarios[s].packed = packed;
+    scenarios[s].padded = (struct Padded *) padded;
+    scenarios[s].samples = (scenarios[s].run == &run_construction) ? CONSTRUCTIONS : samples;
+  }
+
+  printf("{\n  \"benchmark\": \"scaling\",\n  \"processors\": %d,\n  \"samples_per_thread\": %lu,\n  \"shared_fill\": %lu,\n  \"results\": [",
+         crandom_thread_count(), (unsigned long) samples, (unsigned long) fill);
+
+  for(s = 0; s < 4; ++s) {
+    for(t = 1; t <= maxThreads; ++t) {
+      rate = measure(&scenarios[s], t);
+      if( t == 1 )
+        single = rate;
+      report(scenarios[s].name, t, rate, single, &first);
+    }
+  }
+
+  /* warm up the jump tables and the pages of the array */
+  if( !crandom_parallel_fill(crandom, array, fill, maxThreads) )
+    return 1;
+  for(t = 1; t <= maxThreads; ++t) {
+    start = bench_now();
+    if( !crandom_parallel_fill(crandom, array, fill, t) )
+      return 1;
+    rate = fill / (bench_now() - start);
+    if( t == 1 )
+      single = rate;
+    report("shared_fill", t, rate, single, &first);
+  }
+
+  printf("\n  ]\n}\n");
+
+  crandom->release(crandom);
+  free(array);
+  free(packed);
+  free(padded);
+  return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+/*
+ * Startup cost: for every engine and seeding method, the construction
+ * throughput (streams/s, create and release in a loop) and the time to
+ * the first sample (create plus the first crandom->next, which runs the
+ * first dsfmt_gen_rand_all), as JSON on the standard output. The methods:
+ *
+ *   - seed: dSFMTRandomNewBySeed (malloc, dsfmt_init_gen_rand and the
+ *     period certification);
+ *   - array: dSFMTRandomNewByArray with a key {seed, stream}, the streams
+ *     of crandom_parallel_mc;
+ *   - array_reuse: dSFMTRandomInitByArray of one pooled object, no malloc;
+ *   - clone: dSFMTRandomClone of a seeded generator (malloc and copy);
+ *   - clone_jump: clone plus dSFMTRandomJump of the source by 2^40 values,
+ *     i.e. bulk creation of non-overlapping substreams.
+ *
+ * "first_ns" is the first creation of a method in the process (cold code,
+ * allocator and, for clone_jump, dsfmt_jump_prepare); it is the startup
+ * cost of a short job only for the first method run, so pass a method
+ * name as a filter to measure one method in a fresh process.
+ *
+ *   cc -O2 -DDSFMT_MEXP=19937 bench_startup.c benchmark.c crandom.c jump.c dSFMT/dSFMT.c -lm
+ *   ./a.out [streams] [method filter]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "crandom.h"
+#include "dSFMT/dSFMT.h"
+#include "jump.h"
+
+
+#define STREAMS (1 << 14)
+#define LATENCIES (1024)
+
+/* Time limit of a measurement in seconds (clone_jump is slow) */
+#define BUDGET (1.0)
+
+/* Distance of the clone_jump substreams */
+#define STRIDE ((size_t) 1 << 40)
+
+
+/**
+ * Seeding method: create returns the stream number i, destroy ends it
+ */
+struct Method {
+  const char * name;
+  struct cRandom * (* create)(size_t i);
+  void (* destroy)(struct cRandom * crandom);
+};
+
+
+/* Seeded generator of clone and clone_jump, pooled object of array_reuse */
+static struct cRandom * source = NULL;
+static struct cRandom * pooled = NULL;
+
+
+static struct cRandom * create_seed(size_t i) {
+  return dSFMTRandomNewBySeed((int) i);
+}
+
+
+static struct cRandom * create_array(size_t i) {
+  int key[3];
+
+  key[0] = 12345;
+  key[1] = (int) (i & 0xffffffffu);
+  key[2] = (int) ((i >> 16) >> 16);
+  return dSFMTRandomNewByArray(key, 3);
+}
+
+
+static struct cRandom * create_array_reuse(size_t i) {
+  int key[3];
+
+  key[0] = 12345;
+  key[1] = (int) (i & 0xffffffffu);
+  key[2] = (int) ((i >> 16) >> 16);
+  dSFMTRandomInitByArray(pooled, key, 3);
+  return pooled;
+}
+
+
+static struct cRandom * create_clone(size_t i) {
+  (void) i;
+  return dSFMTRandomClone(source);
+}
+
+
+static struct cRandom * create_clone_jump(size_t i) {
+  struct cRandom * crandom = dSFMTRandomClone(source);
+
+  (void) i;
+  if( crandom != NULL && !dSFMTRandomJump(source, STRIDE) ) {
+    crandom->release(crandom);
+    return NULL;
+  }
+  return crandom;
+}
+
+
+static void destroy_release(struct cRandom * crandom) {
+  crandom->release(crandom);
+}
+
+
+static void destroy_none(struct cRandom * crandom) {
+  (void) crandom;
+}
+
+
+static const struct Method methods[] = {
+  { "seed",        &create_seed,        &destroy_release },
+  { "array",       &create_array,       &destroy_release },
+  { "array_reuse", &create_array_reuse, &destroy_none },
+  { "clone",       &create_clone,       &destroy_release },
+  { "clone_jump",  &create_clone_jump,  &destroy_release }
+};
+
+
+/**
+ * Returns the ticks of create plus the first sample, or 0 on failure
+ */
+static unsigned long long first_sample(const struct Method * method, size_t i) {
+  unsigned long long t0, t1;
+  struct cRandom * crandom;
+  double x;
+
+  t0 = bench_ticks();
+  crandom = method->create(i);
+  if( crandom == NULL )
+    return 0;
+  x = crandom->next(crandom);
+  t1 = bench_ticks();
+
+  bench_sink = x;
+  method->destroy(crandom);
+  return t1 - t0;
+}
+
+
+int main(int argc, char ** argv) {
+  const size_t streams = (argc > 1) ? (size_t) atof(argv[1]) : STREAMS;
+  const char * filter = (argc > 2) ? argv[2] : NULL;
+  const int pinned = bench_pin(0);
+  const double ratio = bench_ticks_per_ns();
+  double * latency = (double *) malloc(LATENCIES * sizeof(double));
+  double start, seconds, first, median;
+  size_t m, n;
+  unsigned long long dt;
+  int k, first_result = 1;
+
+  source = dSFMTRandomNewBySeed(12345);
+  pooled = dSFMTRandomNewBySeed(12345);
+  if( latency == NULL || source == NULL || pooled == NULL || streams == 0 )
+    return 1;
+
+  printf("{\n  \"benchmark\": \"startup\",\n  \"streams\": %lu,\n  \"pinned\": %s,\n  \"ticks_per_ns\": %.4f,\n"
+         "  \"mexp\": %d,\n  \"state_bytes\": %lu,\n  \"results\": [",
+         (unsigned long) streams, pinned ? "true" : "false", ratio, DSFMT_MEXP, (unsigned long) sizeof(dsfmt_t));
+
+  for(m = 0; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+    if( filter != NULL && strstr(methods[m].name, filter) == NULL )
+      continue;
+
+    /* cold: the first use of the method in the process */
+    dt = first_sample(&methods[m], 0);
+    if( dt == 0 )
+      return 1;
+    first = dt / ratio;
+
+    /* time to the first sample of a fresh stream */
+    start = bench_now();
+    for(k = 0; k < LATENCIES && (k < 16 || bench_now() - start < BUDGET); ++k) {
+      dt = first_sample(&methods[m], (size_t) k + 1);
+      if( dt == 0 )
+        return 1;
+      latency[k] = dt / ratio;
+    }
+
+    /* construction throughput */
+    start = bench_now();
+    for(n = 0; n < streams; ++n) {
+      struct cRandom * crandom = methods[m].create(n);
+
+      if( crandom == NULL )
+        return 1;
+      methods[m].destroy(crandom);
+      if( (n & 63) == 63 && bench_now() - start >= BUDGET ) {
+        ++n;
+        break;
+      }
+    }
+    seconds = bench_now() - start;
+
+    /* sorts latency */
+    median = bench_median(latency, k);
+
+    printf("%s\n    {\"engine\": \"dSFMT\", \"method\": ", first_result ? "" : ",");
+    bench_json_string(stdout, methods[m].name);
+    printf(", \"first_ns\": %.1f, \"first_sample_ns\": %.1f, \"first_sample_p99_ns\": %.1f, "
+           "\"latencies\": %d, \"streams_per_second\": %.4g, \"ns_per_stream\": %.1f, \"measured_streams\": %lu}",
+           first, median, latency[(k - 1) * 99 / 100], k,
+           n / seconds, 1e9 * seconds / n, (unsigned long) n);
+    first_result = 0;
+  }
+
+  printf("\n  ]\n}\n");
+
+  source->release(source);
+  pooled->release(pooled);
+  free(latency);
+  return 0;
+}
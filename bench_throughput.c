@@ -0,0 +1,235 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+/*
+ * Throughput of every function of crandom.h: ns/sample and samples/s
+ * for every engine, parameter regime and (for the batch forms) buffer
+ * size, as JSON on the standard output, with hardware counters per
+ * sample (IPC, instructions, cache and branch misses) where Linux
+ * perf_event_open is permitted.
+ *
+ *   cc -O2 -DDSFMT_MEXP=19937 bench_throughput.c benchmark.c crandom.c dSFMT/dSFMT.c -lm
+ *   ./a.out [samples per repeat] [repeats] [name filter]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "crandom.h"
+
+
+#define SAMPLES (1 << 24)
+#define REPEATS (5)
+
+/* Buffer of the scalar forms */
+#define SCALAR_BUFFER (1024)
+
+
+/**
+ * Engine under test
+ */
+struct Engine {
+  const char * name;
+  struct cRandom * (* create)(int seed);
+};
+
+
+static const struct Engine engines[] = {
+  { "dSFMT", &dSFMTRandomNewBySeed }
+};
+
+
+/**
+ * Generates size samples into array
+ */
+typedef void (* Generate)(struct cRandom * crandom, double * array, size_t size);
+
+
+struct Case {
+  const char * name;
+  const char * form;     /* "scalar" or "batch" */
+  const char * params;
+  Generate generate;
+};
+
+
+#define SCALAR(fn, call)                                                  \
+  static void fn(struct cRandom * crandom, double * array, size_t size) { \
+    size_t i;                                                             \
+    for(i = 0; i < size; ++i)                                             \
+      array[i] = (double) (call);                                         \
+  }
+
+SCALAR(s_next, crandom->next(crandom))
+SCALAR(s_bernoulli, bernoulli(crandom, 0.5))
+SCALAR(s_binomial_10, binomial(crandom, 10, 0.3))
+SCALAR(s_binomial_1000, binomial(crandom, 1000, 0.3))
+SCALAR(s_equilikely, equilikely(crandom, 1, 6))
+SCALAR(s_geometric_01, geometric(crandom, 0.1))
+SCALAR(s_geometric_09, geometric(crandom, 0.9))
+SCALAR(s_pascal, pascal(crandom, 5, 0.5))
+SCALAR(s_poisson_05, Poisson(crandom, 0.5))
+SCALAR(s_poisson_5, Poisson(crandom, 5.0))
+SCALAR(s_poisson_50, Poisson(crandom, 50.0))
+SCALAR(s_poisson_500, Poisson(crandom, 500.0))
+SCALAR(s_uniform, uniform(crandom, -1.0, 1.0))
+SCALAR(s_exponential, exponential(crandom, 1.0))
+SCALAR(s_erlang_3, erlang(crandom, 3, 1.0))
+SCALAR(s_erlang_30, erlang(crandom, 30, 1.0))
+SCALAR(s_normal, normal(crandom, 0.0, 1.0))
+SCALAR(s_lognormal, lognormal(crandom, 0.0, 1.0))
+SCALAR(s_chisquare_3, chisquare(crandom, 3))
+SCALAR(s_chisquare_30, chisquare(crandom, 30))
+SCALAR(s_student_5, student(crandom, 5))
+SCALAR(s_power_law, power_law(crandom, -2.5, 1.0))
+
+
+static void b_random(struct cRandom * crandom, double * array, size_t size) {
+  random_fill(crandom, array, size);
+}
+
+
+static void b_uniform(struct cRandom * crandom, double * array, size_t size) {
+  uniform_fill(crandom, -1.0, 1.0, array, size);
+}
+
+
+static void b_exponential(struct cRandom * crandom, double * array, size_t size) {
+  exponential_fill(crandom, 1.0, array, size);
+}
+
+
+static void b_normal(struct cRandom * crandom, double * array, size_t size) {
+  normal_fill(crandom, 0.0, 1.0, array, size);
+}
+
+
+static const struct Case cases[] = {
+  { "next",        "scalar", "",                 &s_next },
+  { "bernoulli",   "scalar", "p=0.5",            &s_bernoulli },
+  { "binomial",    "scalar", "n=10,p=0.3",       &s_binomial_10 },
+  { "binomial",    "scalar", "n=1000,p=0.3",     &s_binomial_1000 },
+  { "equilikely",  "scalar", "a=1,b=6",          &s_equilikely },
+  { "geometric",   "scalar", "p=0.1",            &s_geometric_01 },
+  { "geometric",   "scalar", "p=0.9",            &s_geometric_09 },
+  { "pascal",      "scalar", "n=5,p=0.5",        &s_pascal },
+  { "Poisson",     "scalar", "m=0.5",            &s_poisson_05 },
+  { "Poisson",     "scalar", "m=5",              &s_poisson_5 },
+  { "Poisson",     "scalar", "m=50",             &s_poisson_50 },
+  { "Poisson",     "scalar", "m=500",            &s_poisson_500 },
+  { "uniform",     "scalar", "a=-1,b=1",         &s_uniform },
+  { "exponential", "scalar", "m=1",              &s_exponential },
+  { "erlang",      "scalar", "n=3,b=1",          &s_erlang_3 },
+  { "erlang",      "scalar", "n=30,b=1",         &s_erlang_30 },
+  { "normal",      "scalar", "m=0,s=1",          &s_normal },
+  { "lognormal",   "scalar", "a=0,b=1",          &s_lognormal },
+  { "chisquare",   "scalar", "n=3",              &s_chisquare_3 },
+  { "chisquare",   "scalar", "n=30",             &s_chisquare_30 },
+  { "student",     "scalar", "n=5",              &s_student_5 },
+  { "power_law",   "scalar", "k=-2.5,c=1",       &s_power_law },
+  { "random_fill",      "batch", "",             &b_random },
+  { "uniform_fill",     "batch", "a=-1,b=1",     &b_uniform },
+  { "exponential_fill", "batch", "m=1",          &b_exponential },
+  { "normal_fill",      "batch", "m=0,s=1",      &b_normal }
+};
+
+
+/* Buffer sizes of the batch forms */
+static const size_t buffers[] = { 64, 1024, 16384, 262144 };
+
+
+/**
+ * Runs samples samples in chunks of buffer, returns seconds
+ */
+static double run(const struct Case * c, struct cRandom * crandom, double * array, size_t buffer, size_t samples) {
+  double start = bench_now(), sum = 0.0;
+  size_t done, n;
+
+  for(done = 0; done < samples; done += n) {
+    n = (samples - done < buffer) ? samples - done : buffer;
+    c->generate(crandom, array, n);
+    sum += array[n - 1];
+  }
+  bench_sink = sum;
+
+  return bench_now() - start;
+}
+
+
+int main(int argc, char ** argv) {
+  const size_t samples = (argc > 1) ? (size_t) atof(argv[1]) : SAMPLES;
+  const int repeats = (argc > 2) ? atoi(argv[2]) : REPEATS;
+  const char * filter = (argc > 3) ? argv[3] : NULL;
+  const int pinned = bench_pin(0);
+  double * array = (double *) malloc(buffers[sizeof(buffers) / sizeof(buffers[0]) - 1] * sizeof(double));
+  double * seconds = (double *) malloc(repeats * sizeof(double));
+  struct BenchCounters counters;
+  const int available = bench_counters_open(&counters);
+  double median;
+  size_t e, c, b, buffer;
+  int r, first = 1;
+
+  if( array == NULL || seconds == NULL || repeats <= 0 || samples == 0 )
+    return 1;
+
+  printf("{\n  \"benchmark\": \"throughput\",\n  \"samples\": %lu,\n  \"repeats\": %d,\n  \"pinned\": %s,\n"
+         "  \"counters_available\": %d,\n  \"results\": [",
+         (unsigned long) samples, repeats, pinned ? "true" : "false", available);
+
+  for(e = 0; e < sizeof(engines) / sizeof(engines[0]); ++e) {
+    for(c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+      if( filter != NULL && strstr(cases[c].name, filter) == NULL )
+        continue;
+
+      for(b = 0; b < sizeof(buffers) / sizeof(buffers[0]); ++b) {
+        struct cRandom * crandom = engines[e].create(12345);
+
+        if( crandom == NULL )
+          return 1;
+
+        buffer = (strcmp(cases[c].form, "batch") == 0) ? buffers[b] : SCALAR_BUFFER;
+
+        /* warm up: caches, branch predictors, the clock frequency */
+        run(&cases[c], crandom, array, buffer, samples / 4 + 1);
+        bench_counters_start(&counters);
+        for(r = 0; r < repeats; ++r)
+          seconds[r] = run(&cases[c], crandom, array, buffer, samples);
+        bench_counters_stop(&counters);
+        crandom->release(crandom);
+
+        /* sorts seconds, so seconds[0] is the minimum */
+        median = bench_median(seconds, repeats);
+
+        printf("%s\n    {\"engine\": ", first ? "" : ",");
+        bench_json_string(stdout, engines[e].name);
+        printf(", \"function\": ");
+        bench_json_string(stdout, cases[c].name);
+        printf(", \"form\": ");
+        bench_json_string(stdout, cases[c].form);
+        printf(", \"params\": ");
+        bench_json_string(stdout, cases[c].params);
+        printf(", \"buffer\": %lu, \"ns_per_sample\": %.3f, \"ns_per_sample_min\": %.3f, \"samples_per_second\": %.4g, ",
+               (unsigned long) buffer, 1e9 * median / samples, 1e9 * seconds[0] / samples, samples / median);
+        bench_counters_json(stdout, &counters, (double) samples * repeats);
+        printf("}");
+        first = 0;
+
+        /* the scalar forms do not depend on the buffer */
+        if( strcmp(cases[c].form, "scalar") == 0 )
+          break;
+      }
+    }
+  }
+
+  printf("\n  ]\n}\n");
+
+  bench_counters_close(&counters);
+  free(array);
+  free(seconds);
+  return 0;
+}
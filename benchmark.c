@@ -0,0 +1,266 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define BENCH_RDTSCP
+#endif
+
+#include "benchmark.h"
+
+
+volatile double bench_sink;
+
+
+/**
+ * Returns the time in seconds
+ */
+double bench_now(void) {
+#if defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+#else
+  return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+/**
+ * Returns the time stamp counter
+ */
+unsigned long long bench_ticks(void) {
+#if defined(BENCH_RDTSCP)
+  unsigned int aux;
+
+  return __rdtscp(&aux);
+#else
+  return (unsigned long long) (1e9 * bench_now());
+#endif
+}
+
+
+/**
+ * Returns the number of ticks per nanosecond
+ */
+double bench_ticks_per_ns(void) {
+  static double ratio = 0.0;
+  unsigned long long t0;
+  double s0, s1;
+
+  if( ratio == 0.0 ) {
+    s0 = bench_now();
+    t0 = bench_ticks();
+    do {
+      s1 = bench_now();
+    } while( s1 - s0 < 0.02 );
+    ratio = (bench_ticks() - t0) / (1e9 * (s1 - s0));
+  }
+
+  return ratio;
+}
+
+
+/**
+ * Pins the calling thread
+ */
+int bench_pin(int cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void) cpu;
+  return 0;
+#endif
+}
+
+
+/**
+ * Opens the counters
+ */
+int bench_counters_open(struct BenchCounters * counters) {
+  int i, available = 0;
+#if defined(__linux__) && defined(__NR_perf_event_open)
+  static const unsigned long long config[BENCH_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+  struct perf_event_attr attr;
+
+  for(i = 0; i < BENCH_COUNTERS; ++i) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config[i];
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    counters->fd[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if( counters->fd[i] >= 0 )
+      ++available;
+    counters->value[i] = -1.0;
+  }
+#else
+  for(i = 0; i < BENCH_COUNTERS; ++i) {
+    counters->fd[i] = -1;
+    counters->value[i] = -1.0;
+  }
+#endif
+
+  return available;
+}
+
+
+/**
+ * Closes the counters
+ */
+void bench_counters_close(struct BenchCounters * counters) {
+  int i;
+
+  for(i = 0; i < BENCH_COUNTERS; ++i) {
+#if defined(__linux__)
+    if( counters->fd[i] >= 0 )
+      close(counters->fd[i]);
+#endif
+    counters->fd[i] = -1;
+  }
+}
+
+
+/**
+ * Resets and starts the counters
+ */
+void bench_counters_start(struct BenchCounters * counters) {
+  int i;
+
+  for(i = 0; i < BENCH_COUNTERS; ++i) {
+#if defined(__linux__)
+    if( counters->fd[i] >= 0 ) {
+      ioctl(counters->fd[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(counters->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+    counters->value[i] = -1.0;
+  }
+}
+
+
+/**
+ * Stops the counters and stores their values
+ */
+void bench_counters_stop(struct BenchCounters * counters) {
+  int i;
+#if defined(__linux__)
+  unsigned long long data[3];
+
+  for(i = 0; i < BENCH_COUNTERS; ++i) {
+    if( counters->fd[i] >= 0 )
+      ioctl(counters->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+  }
+  for(i = 0; i < BENCH_COUNTERS; ++i) {
+    counters->value[i] = -1.0;
+    /* value, time enabled, time running */
+    if( counters->fd[i] >= 0 && read(counters->fd[i], data, sizeof(data)) == (ssize_t) sizeof(data) && data[2] > 0 )
+      counters->value[i] = (double) data[0] * ((double) data[1] / (double) data[2]);
+  }
+#else
+  for(i = 0; i < BENCH_COUNTERS; ++i)
+    counters->value[i] = -1.0;
+#endif
+}
+
+
+static void json_ratio(FILE * file, const char * name, double numerator, double denominator, int * first) {
+  fprintf(file, "%s\"%s\": ", *first ? "" : ", ", name);
+  if( numerator >= 0.0 && denominator > 0.0 )
+    fprintf(file, "%.4g", numerator / denominator);
+  else
+    fprintf(file, "null");
+  *first = 0;
+}
+
+
+/**
+ * Writes the JSON member "counters"
+ */
+void bench_counters_json(FILE * file, const struct BenchCounters * counters, double samples) {
+  const double * v = counters->value;
+  int i, first = 1;
+
+  for(i = 0; i < BENCH_COUNTERS && v[i] < 0.0; ++i)
+    ;
+  if( i == BENCH_COUNTERS ) {
+    fprintf(file, "\"counters\": null");
+    return;
+  }
+
+  fprintf(file, "\"counters\": {");
+  json_ratio(file, "ipc", v[BENCH_INSTRUCTIONS], v[BENCH_CYCLES] >= 0.0 ? v[BENCH_CYCLES] : -1.0, &first);
+  json_ratio(file, "cycles_per_sample", v[BENCH_CYCLES], samples, &first);
+  json_ratio(file, "instructions_per_sample", v[BENCH_INSTRUCTIONS], samples, &first);
+  json_ratio(file, "cache_misses_per_sample", v[BENCH_CACHE_MISSES], samples, &first);
+  json_ratio(file, "branch_misses_per_sample", v[BENCH_BRANCH_MISSES], samples, &first);
+  fprintf(file, "}");
+}
+
+
+static int compare_doubles(const void * lhs, const void * rhs) {
+  const double l = *(const double *) lhs;
+  const double r = *(const double *) rhs;
+
+  return (l < r) ? -1 : (r < l) ? 1 : 0;
+}
+
+
+/**
+ * Sorts values and returns their median
+ */
+double bench_median(double * values, int n) {
+  qsort(values, n, sizeof(double), &compare_doubles);
+
+  return (n % 2) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+
+/**
+ * Writes s as a JSON string literal
+ */
+void bench_json_string(FILE * file, const char * s) {
+  fputc('"', file);
+  for(; *s; ++s) {
+    if( *s == '"' || *s == '\\' )
+      fprintf(file, "\\%c", *s);
+    else if( (unsigned char) *s < 0x20 )
+      fprintf(file, "\\u%04x", (unsigned char) *s);
+    else
+      fputc(*s, file);
+  }
+  fputc('"', file);
+}
@@ -0,0 +1,125 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __benchmark_h__
+#define __benchmark_h__
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Support of the bench_*.c drivers (POSIX): timer, thread pinning,
+ * summary of repeats and JSON output.
+ */
+
+
+/**
+ * Sink for benchmark results, so the compiler cannot drop the work
+ */
+extern volatile double bench_sink;
+
+
+/**
+ * Returns the time in seconds from an arbitrary origin (monotonic clock)
+ */
+double bench_now(void);
+
+
+/**
+ * Returns the time stamp counter (rdtscp on x86; nanoseconds of the
+ * monotonic clock elsewhere). It waits for the previous instructions.
+ */
+unsigned long long bench_ticks(void);
+
+
+/**
+ * Returns the number of ticks per nanosecond (measured once over 20 ms)
+ */
+double bench_ticks_per_ns(void);
+
+
+/**
+ * Pins the calling thread to the processor cpu
+ *
+ * Returns 0 if pinning is not supported or fails, 1 otherwise.
+ */
+int bench_pin(int cpu);
+
+
+/* Hardware counters: cycles, instructions, cache misses, branch misses */
+#define BENCH_CYCLES (0)
+#define BENCH_INSTRUCTIONS (1)
+#define BENCH_CACHE_MISSES (2)
+#define BENCH_BRANCH_MISSES (3)
+#define BENCH_COUNTERS (4)
+
+
+/**
+ * Hardware performance counters of the calling thread (Linux
+ * perf_event_open, user space only). A counter which cannot be opened,
+ * e.g. in a container without perf access, has fd -1 and reads as -1.
+ */
+struct BenchCounters {
+  int fd[BENCH_COUNTERS];
+  double value[BENCH_COUNTERS];
+};
+
+
+/**
+ * Opens the counters; returns the number of available ones
+ */
+int bench_counters_open(struct BenchCounters * counters);
+
+
+/**
+ * Closes the counters
+ */
+void bench_counters_close(struct BenchCounters * counters);
+
+
+/**
+ * Resets and starts the counters
+ */
+void bench_counters_start(struct BenchCounters * counters);
+
+
+/**
+ * Stops the counters and stores their values (scaled if the kernel
+ * multiplexed them) in counters->value
+ */
+void bench_counters_stop(struct BenchCounters * counters);
+
+
+/**
+ * Writes the JSON member "counters" normalized by samples: IPC,
+ * instructions, cache misses and branch misses per sample (null for
+ * unavailable counters, null object when none is available)
+ */
+void bench_counters_json(FILE * file, const struct BenchCounters * counters, double samples);
+
+
+/**
+ * Sorts values and returns their median
+ */
+double bench_median(double * values, int n);
+
+
+/**
+ * Writes s as a JSON string literal
+ */
+void bench_json_string(FILE * file, const char * s);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__benchmark_h__*/
@@ -0,0 +1,213 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "brownian.h"
+
+
+/**
+ * One construction step: w[point] = lw * w[left] + rw * w[right] + sd * z,
+ * where index -1 stands for W(0) = 0.
+ */
+struct BrownianStep {
+  int point;
+  int left;
+  int right;
+
+  double lw;
+  double rw;
+  double sd;
+};
+
+
+struct BrownianPath {
+  int steps;
+
+  struct BrownianStep * order; /* construction steps in dimension order */
+};
+
+
+/**
+ * Prepares the Brownian bridge construction (Jackel, "Monte Carlo methods
+ * in finance", 2002) for an arbitrary number of points
+ */
+static int bridge_order(struct BrownianStep * order, const double * t, int n) {
+  int * map = (int *) calloc(n, sizeof(int));
+  double tl;
+  int i, j, k, l;
+
+  if( map == NULL )
+    return 0;
+
+  map[n - 1] = 1;
+  order[0].point = n - 1;
+  order[0].left = -1;
+  order[0].right = -1;
+  order[0].lw = order[0].rw = 0.0;
+  order[0].sd = sqrt(t[n - 1]);
+
+  for(i = 1, j = 0; i < n; ++i) {
+    while( map[j] )
+      ++j;
+    k = j;
+    while( !map[k] )
+      ++k;
+    /* points j..k-1 are free, k is built, j-1 is built (or is W(0)) */
+    l = j + ((k - 1 - j) >> 1);
+    map[l] = i + 1;
+
+    tl = (j > 0) ? t[j - 1] : 0.0;
+    order[i].point = l;
+    order[i].left = j - 1;
+    order[i].right = k;
+    order[i].lw = (t[k] - t[l]) / (t[k] - tl);
+    order[i].rw = (t[l] - tl) / (t[k] - tl);
+    order[i].sd = sqrt((t[l] - tl) * (t[k] - t[l]) / (t[k] - tl));
+
+    j = k + 1;
+    if( j >= n )
+      j = 0;
+  }
+
+  free(map);
+  return 1;
+}
+
+
+/**
+ * Create a new Brownian path generator
+ */
+struct BrownianPath * BrownianPathNew(int steps, const double * times, enum BrownianConstruction construction) {
+  struct BrownianPath * path;
+  int i;
+
+  assert( 0 < steps );
+  assert( 0.0 < times[0] );
+  for(i = 1; i < steps; ++i)
+    assert( times[i - 1] < times[i] );
+
+  path = (struct BrownianPath *) malloc(sizeof(*path));
+  if( path == NULL )
+    return NULL;
+
+  path->steps = steps;
+  path->order = (struct BrownianStep *) malloc(steps * sizeof(struct BrownianStep));
+  if( path->order == NULL ) {
+    free(path);
+    return NULL;
+  }
+
+  if( construction == BROWNIAN_BRIDGE ) {
+    if( !bridge_order(path->order, times, steps) ) {
+      BrownianPathRelease(path);
+      return NULL;
+    }
+  } else {
+    for(i = 0; i < steps; ++i) {
+      path->order[i].point = i;
+      path->order[i].left = i - 1;
+      path->order[i].right = -1;
+      path->order[i].lw = 1.0;
+      path->order[i].rw = 0.0;
+      path->order[i].sd = sqrt(times[i] - (i > 0 ? times[i - 1] : 0.0));
+    }
+  }
+
+  return path;
+}
+
+
+/**
+ * Releases resources of a BrownianPath object
+ */
+void BrownianPathRelease(struct BrownianPath * path) {
+  if( path == NULL )
+    return;
+
+  free(path->order);
+  free(path);
+}
+
+
+/**
+ * Returns the number of time steps of the path
+ */
+int BrownianPathSteps(const struct BrownianPath * path) {
+  return path->steps;
+}
+
+
+/**
+ * Runs the construction in place: on entry the row order[d].point of w
+ * holds the normals of dimension d, on exit the rows hold the path values.
+ *
+ * Every step is a loop over paths, so it is vectorized across paths.
+ */
+static void build(const struct BrownianPath * path, double * w, size_t paths) {
+  const struct BrownianStep * step;
+  double * x;
+  const double * left;
+  const double * right;
+  double lw, rw, sd;
+  size_t p;
+  int i;
+
+  for(i = 0; i < path->steps; ++i) {
+    step = &path->order[i];
+    x = w + step->point * paths;
+    lw = step->lw;
+    rw = step->rw;
+    sd = step->sd;
+
+    if( step->left < 0 && step->right < 0 ) {
+      for(p = 0; p < paths; ++p)
+        x[p] = sd * x[p];
+    } else if( step->right < 0 ) {
+      left = w + step->left * paths;
+      for(p = 0; p < paths; ++p)
+        x[p] = lw * left[p] + sd * x[p];
+    } else if( step->left < 0 ) {
+      right = w + step->right * paths;
+      for(p = 0; p < paths; ++p)
+        x[p] = rw * right[p] + sd * x[p];
+    } else {
+      left = w + step->left * paths;
+      right = w + step->right * paths;
+      for(p = 0; p < paths; ++p)
+        x[p] = lw * left[p] + rw * right[p] + sd * x[p];
+    }
+  }
+}
+
+
+/**
+ * Generates paths Brownian paths in SoA layout
+ */
+void BrownianPathFill(struct BrownianPath * path, struct cRandom * crandom, double * w, size_t paths) {
+  int i;
+
+  for(i = 0; i < path->steps; ++i)
+    normal_fill(crandom, 0.0, 1.0, w + path->order[i].point * paths, paths);
+
+  build(path, w, paths);
+}
+
+
+/**
+ * Builds paths Brownian paths from given standard normals
+ */
+void BrownianPathFromNormals(const struct BrownianPath * path, const double * z, double * w, size_t paths) {
+  int i;
+
+  for(i = 0; i < path->steps; ++i)
+    memcpy(w + path->order[i].point * paths, z + i * paths, paths * sizeof(double));
+
+  build(path, w, paths);
+}
@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __brownian_h__
+#define __brownian_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Order in which normals are mapped to the points of a path
+ */
+enum BrownianConstruction {
+  BROWNIAN_INCREMENTS, /* i-th normal drives the i-th increment                 */
+  BROWNIAN_BRIDGE      /* 0-th normal drives the terminal point, next ones the
+                          midpoints (so low dimensions carry the most variance) */
+};
+
+
+/**
+ * Prepared generator of standard Brownian paths on a fixed time grid
+ */
+struct BrownianPath;
+
+
+/**
+ * Create a new Brownian path generator
+ *
+ * times are steps strictly increasing positive times; W(0) = 0 is implied.
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct BrownianPath * BrownianPathNew(int steps, const double * times, enum BrownianConstruction construction);
+
+
+/**
+ * Releases resources of a BrownianPath object
+ */
+void BrownianPathRelease(struct BrownianPath * path);
+
+
+/**
+ * Returns the number of time steps of the path
+ */
+int BrownianPathSteps(const struct BrownianPath * path);
+
+
+/**
+ * Generates paths Brownian paths in SoA layout:
+ * W(times[s]) of the p-th path is stored at w[s * paths + p].
+ */
+void BrownianPathFill(struct BrownianPath * path, struct cRandom * crandom, double * w, size_t paths);
+
+
+/**
+ * Builds paths Brownian paths from given standard normals (e.g. normal
+ * transforms of a quasi-random sequence): the d-th dimension of the p-th
+ * path is read from z[d * paths + p]. Output layout is as in BrownianPathFill.
+ */
+void BrownianPathFromNormals(const struct BrownianPath * path, const double * z, double * w, size_t paths);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__brownian_h__*/
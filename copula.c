@@ -0,0 +1,517 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "copula.h"
+
+
+/* Number of vectors generated per block */
+#define COPULA_BLOCK (256)
+
+/* Number of intervals in a quantile table */
+#define COPULA_TABLE (4096)
+
+#define SQRT1_2 (0.70710678118654752440)
+
+
+/**
+ * Prepared marginal distribution
+ */
+struct PreparedMarginal {
+  enum CopulaMarginalKind kind;
+
+  double a;
+  double b;
+
+  double * table; /* COPULA_TABLE + 1 quantiles (for tabulated kinds) */
+};
+
+
+struct GaussianCopula {
+  int dimension;
+
+  double * cholesky;                  /* lower triangle, row-major */
+  struct PreparedMarginal * marginals;
+
+  double * scratch;                   /* dimension * COPULA_BLOCK normals */
+};
+
+
+/*
+ * C89 and the Visual C++ runtime have neither lgamma nor erfc, so the
+ * copula carries its own.
+ */
+
+
+/**
+ * Returns log(Gamma(x)), x > 0 (Lanczos, absolute error below 2e-10)
+ */
+static double log_gamma(double x) {
+  static const double c[6] = {
+    76.18009172947146, -86.50532032941677, 24.01409824083091,
+    -1.231739572450155, 0.1208650973866179e-2, -0.5395239384953e-5
+  };
+  double y = x, t, s = 1.000000000190015;
+  int i;
+
+  t = x + 5.5;
+  t -= (x + 0.5) * log(t);
+  for(i = 0; i < 6; ++i)
+    s += c[i] / ++y;
+  return -t + log(2.5066282746310005 * s / x);
+}
+
+
+/**
+ * Returns erfc(x) (Chebyshev fit, relative error below 1.2e-7)
+ *
+ * The branch is expressed as a selection so that loops over this
+ * function can be vectorized.
+ */
+static double erfc_approx(double x) {
+  const double z = fabs(x);
+  const double t = 1.0 / (1.0 + 0.5 * z);
+  const double r = t * exp(-z * z - 1.26551223 + t * (1.00002368 + t * (0.37409196 + t * (0.09678418 +
+                   t * (-0.18628806 + t * (0.27886807 + t * (-1.13520398 + t * (1.48851587 +
+                   t * (-0.82215223 + t * 0.17087277)))))))));
+
+  return (x >= 0.0) ? r : 2.0 - r;
+}
+
+
+/**
+ * Returns P(a, x) by its series, x < a + 1
+ */
+static double gamma_series(double a, double x) {
+  const double eps = 1e-15;
+  double sum, del, ap;
+  int i;
+
+  ap = a;
+  sum = del = 1.0 / a;
+  for(i = 0; i < 1000; ++i) {
+    ap += 1.0;
+    del *= x / ap;
+    sum += del;
+    if( fabs(del) < fabs(sum) * eps )
+      break;
+  }
+  return sum * exp(-x + a * log(x) - log_gamma(a));
+}
+
+
+/**
+ * Returns Q(a, x) by its continued fraction, x >= a + 1
+ */
+static double gamma_fraction(double a, double x) {
+  const double eps = 1e-15;
+  const double tiny = 1e-300;
+  double del, b, c, d, h, an;
+  int i;
+
+  b = x + 1.0 - a;
+  c = 1.0 / tiny;
+  d = 1.0 / b;
+  h = d;
+  for(i = 1; i < 1000; ++i) {
+    an = -i * (i - a);
+    b += 2.0;
+    d = an * d + b;
+    if( fabs(d) < tiny )
+      d = tiny;
+    c = b + an / c;
+    if( fabs(c) < tiny )
+      c = tiny;
+    d = 1.0 / d;
+    del = d * c;
+    h *= del;
+    if( fabs(del - 1.0) < eps )
+      break;
+  }
+  return exp(-x + a * log(x) - log_gamma(a)) * h;
+}
+
+
+/**
+ * Returns the regularized lower incomplete gamma function P(a, x)
+ */
+static double gamma_p(double a, double x) {
+  if( x <= 0.0 )
+    return 0.0;
+  return (x < a + 1.0) ? gamma_series(a, x) : 1.0 - gamma_fraction(a, x);
+}
+
+
+/**
+ * Returns the regularized upper incomplete gamma function Q(a, x)
+ */
+static double gamma_q(double a, double x) {
+  if( x <= 0.0 )
+    return 1.0;
+  return (x < a + 1.0) ? 1.0 - gamma_series(a, x) : gamma_fraction(a, x);
+}
+
+
+/**
+ * Returns the quantile of gamma(shape, 1) with the upper tail probability
+ * q by Newton's method on log Q(shape, x) from x, a quantile with a larger
+ * tail probability.
+ *
+ * log Q is concave for shape >= 1 (one overshoot, then monotone from the
+ * right) and convex otherwise (monotone from the left).
+ */
+static double gamma_upper_quantile(double shape, double q, double x) {
+  const double lq = log(q > 1e-300 ? q : 1e-300);
+  const double gln = log_gamma(shape);
+  double tail, step;
+  int i;
+
+  for(i = 0; i < 100; ++i) {
+    tail = gamma_q(shape, x);
+    if( !(tail > 0.0) )
+      break;
+    step = (log(tail) - lq) * tail / exp(-x + (shape - 1.0) * log(x) - gln);
+    x += step;
+    if( fabs(step) <= 1e-12 * x )
+      break;
+  }
+  return x;
+}
+
+
+/**
+ * Returns the quantile of gamma(shape, 1) with the lower tail probability
+ * p by Newton's method on log P(shape, x) in log x from x, a quantile with
+ * a larger tail probability (log P is nearly linear in log x at zero).
+ */
+static double gamma_lower_quantile(double shape, double p, double x) {
+  const double gln = log_gamma(shape);
+  double lp, head, step;
+  int i;
+
+  if( !(p > 0.0) )
+    return 0.0;
+
+  lp = log(p);
+  for(i = 0; i < 100; ++i) {
+    head = gamma_p(shape, x);
+    if( !(head > 0.0) )
+      break;
+    step = (log(head) - lp) * head / exp(-x + shape * log(x) - gln);
+    x *= exp(-step);
+    if( fabs(step) <= 1e-12 )
+      break;
+  }
+  return x;
+}
+
+
+/**
+ * Fills table with the quantiles of the gamma(shape, scale) distribution
+ * at i / COPULA_TABLE. The last node is taken at 1 - 1 / (2 * COPULA_TABLE)^2;
+ * the first and the last intervals are not interpolated but inverted by
+ * gamma_lower_quantile and gamma_upper_quantile.
+ */
+static void gamma_table(double * table, double shape, double scale) {
+  double lo = 0.0, hi = shape + 1.0, mid, p;
+  int i, k;
+
+  table[0] = 0.0;
+  for(i = 1; i <= COPULA_TABLE; ++i) {
+    p = (i < COPULA_TABLE) ? ((double) i) / COPULA_TABLE : 1.0 - 0.25 / ((double) COPULA_TABLE * COPULA_TABLE);
+
+    while( gamma_p(shape, hi) < p )
+      hi *= 2.0;
+    for(k = 0; k < 64 && lo < hi; ++k) {
+      mid = 0.5 * (lo + hi);
+      if( gamma_p(shape, mid) < p )
+        lo = mid;
+      else
+        hi = mid;
+    }
+    table[i] = hi;
+    hi = 2.0 * hi + 1.0;
+  }
+
+  for(i = 0; i <= COPULA_TABLE; ++i)
+    table[i] *= scale;
+}
+
+
+static int compare_doubles(const void * lhs, const void * rhs) {
+  const double x = *(const double *) lhs;
+  const double y = *(const double *) rhs;
+
+  return (x > y) - (x < y);
+}
+
+
+/**
+ * Fills table with the quantiles of the sample at i / COPULA_TABLE
+ * (linear interpolation between order statistics)
+ */
+static int empirical_table(double * table, const double * sample, int sampleSize) {
+  double * sorted = (double *) malloc(sampleSize * sizeof(double));
+  double h;
+  int i, k;
+
+  if( sorted == NULL )
+    return 0;
+
+  memcpy(sorted, sample, sampleSize * sizeof(double));
+  qsort(sorted, sampleSize, sizeof(double), &compare_doubles);
+
+  for(i = 0; i <= COPULA_TABLE; ++i) {
+    h = (sampleSize - 1) * ((double) i) / COPULA_TABLE;
+    k = (int) h;
+    if( k >= sampleSize - 1 )
+      table[i] = sorted[sampleSize - 1];
+    else
+      table[i] = sorted[k] + (h - k) * (sorted[k + 1] - sorted[k]);
+  }
+
+  free(sorted);
+  return 1;
+}
+
+
+/**
+ * Computes the Cholesky factor of a row-major symmetric matrix.
+ * Returns 0 if the matrix is not positive definite.
+ */
+static int cholesky(double * l, const double * a, int d) {
+  double s;
+  int i, j, k;
+
+  memset(l, 0, d * d * sizeof(double));
+  for(i = 0; i < d; ++i) {
+    for(j = 0; j <= i; ++j) {
+      s = a[i * d + j];
+      for(k = 0; k < j; ++k)
+        s -= l[i * d + k] * l[j * d + k];
+      if( i == j ) {
+        if( !(s > 0.0) )
+          return 0;
+        l[i * d + i] = sqrt(s);
+      } else {
+        l[i * d + j] = s / l[j * d + j];
+      }
+    }
+  }
+
+  return 1;
+}
+
+
+/**
+ * Create a new Gaussian copula
+ */
+struct GaussianCopula * GaussianCopulaNew(int dimension, const double * correlation, const struct CopulaMarginal * marginals) {
+  struct GaussianCopula * copula;
+  int j;
+
+  assert( 0 < dimension );
+
+  copula = (struct GaussianCopula *) calloc(1, sizeof(*copula));
+  if( copula == NULL )
+    return NULL;
+
+  copula->dimension = dimension;
+  copula->cholesky = (double *) malloc(dimension * dimension * sizeof(double));
+  copula->marginals = (struct PreparedMarginal *) calloc(dimension, sizeof(struct PreparedMarginal));
+  copula->scratch = (double *) malloc(dimension * COPULA_BLOCK * sizeof(double));
+  if( copula->cholesky == NULL || copula->marginals == NULL || copula->scratch == NULL )
+    goto failure;
+
+  if( !cholesky(copula->cholesky, correlation, dimension) )
+    goto failure;
+
+  for(j = 0; j < dimension; ++j) {
+    struct PreparedMarginal * marginal = &copula->marginals[j];
+
+    marginal->kind = marginals[j].kind;
+    marginal->a = marginals[j].a;
+    marginal->b = marginals[j].b;
+
+    if( marginal->kind == COPULA_GAMMA || marginal->kind == COPULA_EMPIRICAL ) {
+      marginal->table = (double *) malloc((COPULA_TABLE + 1) * sizeof(double));
+      if( marginal->table == NULL )
+        goto failure;
+    }
+
+    switch( marginal->kind ) {
+    case COPULA_UNIFORM:
+      assert( marginal->a < marginal->b );
+      break;
+    case COPULA_NORMAL:
+    case COPULA_LOGNORMAL:
+      assert( 0.0 < marginal->b );
+      break;
+    case COPULA_EXPONENTIAL:
+      assert( 0.0 < marginal->a );
+      break;
+    case COPULA_GAMMA:
+      assert( 0.0 < marginal->a && 0.0 < marginal->b );
+      gamma_table(marginal->table, marginal->a, marginal->b);
+      break;
+    case COPULA_EMPIRICAL:
+      assert( 0 < marginals[j].sampleSize );
+      if( !empirical_table(marginal->table, marginals[j].sample, marginals[j].sampleSize) )
+        goto failure;
+      break;
+    }
+  }
+
+  return copula;
+
+failure:
+  GaussianCopulaRelease(copula);
+  return NULL;
+}
+
+
+/**
+ * Releases resources of a GaussianCopula object
+ */
+void GaussianCopulaRelease(struct GaussianCopula * copula) {
+  int j;
+
+  if( copula == NULL )
+    return;
+
+  if( copula->marginals != NULL ) {
+    for(j = 0; j < copula->dimension; ++j)
+      free(copula->marginals[j].table);
+  }
+  free(copula->marginals);
+  free(copula->cholesky);
+  free(copula->scratch);
+  free(copula);
+}
+
+
+/**
+ * Returns the dimension of the copula
+ */
+int GaussianCopulaDimension(const struct GaussianCopula * copula) {
+  return copula->dimension;
+}
+
+
+/**
+ * Fills array with values of the standard normal cdf at array[i]
+ */
+void normal_cdf_fill(double * array, size_t size) {
+  size_t i;
+
+  for(i = 0; i < size; ++i)
+    array[i] = 0.5 * erfc_approx(- array[i] * SQRT1_2);
+}
+
+
+/**
+ * Maps standard normal values x[0..n) to the marginal distribution
+ */
+static void apply_marginal(const struct PreparedMarginal * marginal, double * x, size_t n) {
+  const double a = marginal->a;
+  const double b = marginal->b;
+  const double * table = marginal->table;
+  double t;
+  size_t i, k;
+
+  switch( marginal->kind ) {
+  case COPULA_UNIFORM:
+    normal_cdf_fill(x, n);
+    for(i = 0; i < n; ++i)
+      x[i] = a + (b - a) * x[i];
+    break;
+
+  case COPULA_NORMAL:
+    for(i = 0; i < n; ++i)
+      x[i] = a + b * x[i];
+    break;
+
+  case COPULA_LOGNORMAL:
+    for(i = 0; i < n; ++i)
+      x[i] = exp(a + b * x[i]);
+    break;
+
+  case COPULA_EXPONENTIAL:
+    /* 1 - cdf(x) is computed directly to keep the upper tail accurate */
+    for(i = 0; i < n; ++i)
+      x[i] = - a * log(0.5 * erfc_approx(x[i] * SQRT1_2));
+    break;
+
+  case COPULA_GAMMA:
+    normal_cdf_fill(x, n);
+    for(i = 0; i < n; ++i) {
+      t = x[i] * COPULA_TABLE;
+      k = (size_t) t;
+      if( k >= COPULA_TABLE - 1 )
+        x[i] = b * gamma_upper_quantile(a, 1.0 - x[i], table[COPULA_TABLE - 1] / b);
+      else if( k == 0 )
+        x[i] = b * gamma_lower_quantile(a, x[i], table[1] / b);
+      else
+        x[i] = table[k] + (t - k) * (table[k + 1] - table[k]);
+    }
+    break;
+
+  case COPULA_EMPIRICAL:
+    normal_cdf_fill(x, n);
+    for(i = 0; i < n; ++i) {
+      t = x[i] * COPULA_TABLE;
+      k = (size_t) t;
+      if( k >= COPULA_TABLE )
+        k = COPULA_TABLE - 1;
+      x[i] = table[k] + (t - k) * (table[k + 1] - table[k]);
+    }
+    break;
+  }
+}
+
+
+/**
+ * Generates count random vectors in SoA layout
+ */
+void GaussianCopulaFill(struct GaussianCopula * copula, struct cRandom * crandom, double * out, size_t count) {
+  const int d = copula->dimension;
+  const double * l = copula->cholesky;
+  double * z = copula->scratch;
+  size_t start, n, i;
+  int j, k;
+
+  for(start = 0; start < count; start += n) {
+    n = count - start;
+    if( n > COPULA_BLOCK )
+      n = COPULA_BLOCK;
+
+    /* z[k * n + i] is the k-th independent normal of the i-th vector */
+    normal_fill(crandom, 0.0, 1.0, z, d * n);
+
+    for(j = 0; j < d; ++j) {
+      double * x = out + j * count + start;
+      const double * zk;
+      double ljk;
+
+      zk = z + j * n;
+      ljk = l[j * d + j];
+      for(i = 0; i < n; ++i)
+        x[i] = ljk * zk[i];
+      for(k = 0; k < j; ++k) {
+        zk = z + k * n;
+        ljk = l[j * d + k];
+        for(i = 0; i < n; ++i)
+          x[i] += ljk * zk[i];
+      }
+
+      apply_marginal(&copula->marginals[j], x, n);
+    }
+  }
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __copula_h__
+#define __copula_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Kind of a one-dimensional marginal distribution
+ */
+enum CopulaMarginalKind {
+  COPULA_UNIFORM,     /* uniform(a, b)                       */
+  COPULA_NORMAL,      /* normal(m = a, s = b)                */
+  COPULA_LOGNORMAL,   /* lognormal(a, b)                     */
+  COPULA_EXPONENTIAL, /* exponential(m = a)                  */
+  COPULA_GAMMA,       /* gamma with shape a and scale b      */
+  COPULA_EMPIRICAL    /* empirical distribution of a sample  */
+};
+
+
+/**
+ * Description of a marginal distribution
+ *
+ * COPULA_GAMMA and COPULA_EMPIRICAL marginals are inverted through a
+ * quantile table with linear interpolation, which is built once by
+ * GaussianCopulaNew; the tails of a gamma marginal beyond the outer
+ * nodes (probability 1 / 4096 each) are inverted by Newton's method.
+ * The sample of an empirical marginal is copied.
+ */
+struct CopulaMarginal {
+  enum CopulaMarginalKind kind;
+
+  double a;
+  double b;
+
+  const double * sample;
+  int sampleSize;
+};
+
+
+/**
+ * Prepared Gaussian copula with arbitrary marginals
+ */
+struct GaussianCopula;
+
+
+/**
+ * Create a new Gaussian copula
+ *
+ * correlation is a row-major dimension x dimension correlation matrix,
+ * marginals is an array of dimension marginal descriptions.
+ *
+ * Returns NULL if the correlation matrix is not positive definite or
+ * there is not enough memory.
+ */
+struct GaussianCopula * GaussianCopulaNew(int dimension, const double * correlation, const struct CopulaMarginal * marginals);
+
+
+/**
+ * Releases resources of a GaussianCopula object
+ */
+void GaussianCopulaRelease(struct GaussianCopula * copula);
+
+
+/**
+ * Returns the dimension of the copula
+ */
+int GaussianCopulaDimension(const struct GaussianCopula * copula);
+
+
+/**
+ * Generates count random vectors in SoA layout:
+ * the j-th coordinate of the i-th vector is stored at out[j * count + i].
+ *
+ * NOTE: a GaussianCopula object keeps a scratch buffer, so do not share
+ *       one object between threads.
+ */
+void GaussianCopulaFill(struct GaussianCopula * copula, struct cRandom * crandom, double * out, size_t count);
+
+
+/**
+ * Fills array with values of the standard normal cdf at array[i]
+ * (relative error below 1.2e-7 in both tails)
+ */
+void normal_cdf_fill(double * array, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__copula_h__*/
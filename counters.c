@@ -0,0 +1,220 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "counters.h"
+
+
+static const char * const names[CRANDOM_COUNTER_COUNT] = {
+  "uniforms",
+  "refills",
+  "bernoulli",
+  "binomial",
+  "equilikely",
+  "geometric",
+  "pascal",
+  "Poisson",
+  "uniform",
+  "exponential",
+  "erlang",
+  "normal",
+  "lognormal",
+  "chisquare",
+  "student",
+  "power_law",
+  "random_fill",
+  "uniform_fill",
+  "exponential_fill",
+  "normal_fill",
+  "Poisson_iterations",
+  "gillespie_rejections",
+  "nhpp_rejections",
+  "walk_rejections"
+};
+
+
+/**
+ * Returns the name of a counter
+ */
+const char * crandom_counter_name(int counter) {
+  if( counter < 0 || counter >= CRANDOM_COUNTER_COUNT )
+    return NULL;
+  return names[counter];
+}
+
+
+#ifdef CRANDOM_COUNTERS
+
+
+/*
+ * The blocks of all threads are kept in a list. A block of a finished
+ * thread keeps its counts and is reused by the next new thread (POSIX);
+ * on Windows the blocks of finished threads are not reused.
+ */
+struct CounterBlock {
+  uint64_t value[CRANDOM_COUNTER_COUNT];
+  struct CounterBlock * next;
+  int busy;
+};
+
+
+static struct CounterBlock * blocks = NULL;
+
+CRANDOM_THREAD_LOCAL uint64_t * crandom_counters_local = NULL;
+
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+static volatile LONG spin = 0;
+
+static void lock(void) {
+  while( InterlockedExchange(&spin, 1) != 0 )
+    Sleep(0);
+}
+
+static void unlock(void) {
+  InterlockedExchange(&spin, 0);
+}
+
+static void on_attach(struct CounterBlock * block) {
+  (void) block;
+}
+
+#define LOAD(x) (*(volatile uint64_t *) &(x))
+#define STORE(x, v) (*(volatile uint64_t *) &(x) = (v))
+
+#else
+
+#include <pthread.h>
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+static int keyed = 0;
+
+static void lock(void) {
+  pthread_mutex_lock(&mutex);
+}
+
+static void unlock(void) {
+  pthread_mutex_unlock(&mutex);
+}
+
+/**
+ * Thread exit: the block keeps its counts and becomes free
+ */
+static void detach(void * block) {
+  lock();
+  ((struct CounterBlock *) block)->busy = 0;
+  unlock();
+}
+
+static void make_key(void) {
+  keyed = (pthread_key_create(&key, &detach) == 0);
+}
+
+static void on_attach(struct CounterBlock * block) {
+  pthread_once(&once, &make_key);
+  if( keyed )
+    pthread_setspecific(key, block);
+}
+
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+#endif
+
+
+/**
+ * Attaches a free or a new block to the calling thread
+ */
+uint64_t * crandom_counters_attach(void) {
+  struct CounterBlock * block;
+
+  lock();
+  for(block = blocks; block != NULL && block->busy; block = block->next)
+    ;
+  if( block == NULL ) {
+    block = (struct CounterBlock *) calloc(1, sizeof(*block));
+    if( block != NULL ) {
+      block->next = blocks;
+      blocks = block;
+    }
+  }
+  if( block != NULL )
+    block->busy = 1;
+  unlock();
+
+  if( block == NULL )
+    return NULL;
+
+  on_attach(block);
+  crandom_counters_local = block->value;
+  return block->value;
+}
+
+
+int crandom_counters_enabled(void) {
+  return 1;
+}
+
+
+/**
+ * Sums the counters of all threads
+ */
+void crandom_counters_snapshot(struct cRandomCounters * counters) {
+  struct CounterBlock * block;
+  int i;
+
+  memset(counters, 0, sizeof(*counters));
+
+  lock();
+  for(block = blocks; block != NULL; block = block->next) {
+    for(i = 0; i < CRANDOM_COUNTER_COUNT; ++i)
+      counters->value[i] += LOAD(block->value[i]);
+  }
+  unlock();
+}
+
+
+/**
+ * Sets the counters of all threads to zero
+ */
+void crandom_counters_reset(void) {
+  struct CounterBlock * block;
+  int i;
+
+  lock();
+  for(block = blocks; block != NULL; block = block->next) {
+    for(i = 0; i < CRANDOM_COUNTER_COUNT; ++i)
+      STORE(block->value[i], 0);
+  }
+  unlock();
+}
+
+
+#else /* CRANDOM_COUNTERS */
+
+
+int crandom_counters_enabled(void) {
+  return 0;
+}
+
+
+void crandom_counters_snapshot(struct cRandomCounters * counters) {
+  memset(counters, 0, sizeof(*counters));
+}
+
+
+void crandom_counters_reset(void) {
+}
+
+
+#endif /* CRANDOM_COUNTERS */
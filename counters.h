@@ -0,0 +1,156 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __counters_h__
+#define __counters_h__
+
+#include "dSFMT/dSFMT.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Instrumentation counters.
+ *
+ * The library counts its work only when it is compiled with
+ * CRANDOM_COUNTERS defined; otherwise the counting sites expand to nothing
+ * and the functions below report zeros.
+ *
+ * Every thread counts into its own block (no atomic read-modify-write, no
+ * shared cache lines); a snapshot sums the blocks of all threads, the
+ * finished ones included.
+ *
+ * NOTE: with CRANDOM_COUNTERS the library needs POSIX threads (Windows
+ *       threads on Windows), e.g. cc -DCRANDOM_COUNTERS ... -pthread
+ */
+
+
+/**
+ * Counters
+ */
+enum cRandomCounter {
+  /* uniforms taken from dSFMT generators (next and random_fill) */
+  CRANDOM_UNIFORMS,
+  /* dsfmt_gen_rand_all refills of dSFMT generators */
+  CRANDOM_REFILLS,
+
+  /* calls of the functions of crandom.h, nested calls included
+     (e.g. lognormal calls normal) */
+  CRANDOM_BERNOULLI,
+  CRANDOM_BINOMIAL,
+  CRANDOM_EQUILIKELY,
+  CRANDOM_GEOMETRIC,
+  CRANDOM_PASCAL,
+  CRANDOM_POISSON,
+  CRANDOM_UNIFORM,
+  CRANDOM_EXPONENTIAL,
+  CRANDOM_ERLANG,
+  CRANDOM_NORMAL,
+  CRANDOM_LOGNORMAL,
+  CRANDOM_CHISQUARE,
+  CRANDOM_STUDENT,
+  CRANDOM_POWER_LAW,
+  CRANDOM_RANDOM_FILL,
+  CRANDOM_UNIFORM_FILL,
+  CRANDOM_EXPONENTIAL_FILL,
+  CRANDOM_NORMAL_FILL,
+
+  /* iterations of the loops with a random trip count */
+  CRANDOM_POISSON_ITERATIONS,       /* Poisson: one per uniform */
+  CRANDOM_GILLESPIE_REJECTIONS,     /* rejected members in the reaction selection */
+  CRANDOM_NHPP_REJECTIONS,          /* rejected proposals of the thinning */
+  CRANDOM_WALK_REJECTIONS,          /* rejected steps of the second order walk */
+
+  CRANDOM_COUNTER_COUNT
+};
+
+
+/**
+ * Snapshot of the counters
+ */
+struct cRandomCounters {
+  uint64_t value[CRANDOM_COUNTER_COUNT];
+};
+
+
+/**
+ * Returns 1 if the library is compiled with CRANDOM_COUNTERS, 0 otherwise
+ */
+int crandom_counters_enabled(void);
+
+
+/**
+ * Returns the name of a counter, e.g. "uniforms" or "normal"
+ */
+const char * crandom_counter_name(int counter);
+
+
+/**
+ * Sums the counters of all threads into counters.
+ *
+ * NOTE: the counters of the running threads are read without stopping
+ *       them, so a snapshot is not an atomic cut across threads.
+ */
+void crandom_counters_snapshot(struct cRandomCounters * counters);
+
+
+/**
+ * Sets the counters of all threads to zero
+ *
+ * NOTE: increments racing with the reset may survive it.
+ */
+void crandom_counters_reset(void);
+
+
+/*
+ * Counting sites of the library: CRANDOM_COUNT(counter, n) adds n to the
+ * counter of the calling thread; n is not evaluated without
+ * CRANDOM_COUNTERS.
+ */
+#ifdef CRANDOM_COUNTERS
+
+#if defined(_MSC_VER)
+#define CRANDOM_THREAD_LOCAL __declspec(thread)
+#define CRANDOM_COUNTER_ADD(x, n) (*(volatile uint64_t *) &(x) += (n))
+#else
+#define CRANDOM_THREAD_LOCAL __thread
+#define CRANDOM_COUNTER_ADD(x, n) \
+  __atomic_store_n(&(x), __atomic_load_n(&(x), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+#endif
+
+/* Block of the calling thread, NULL before its first count */
+extern CRANDOM_THREAD_LOCAL uint64_t * crandom_counters_local;
+
+/**
+ * Attaches a block to the calling thread, returns NULL if there is not
+ * enough memory (the counts are dropped then)
+ */
+uint64_t * crandom_counters_attach(void);
+
+#define CRANDOM_COUNT(counter, n)                                         \
+  do {                                                                    \
+    uint64_t * crandom_block_ = crandom_counters_local;                   \
+    if( crandom_block_ == NULL )                                          \
+      crandom_block_ = crandom_counters_attach();                         \
+    if( crandom_block_ != NULL )                                          \
+      CRANDOM_COUNTER_ADD(crandom_block_[counter], (uint64_t) (n));       \
+  } while( 0 )
+
+#else
+
+#define CRANDOM_COUNT(counter, n) ((void) 0)
+
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__counters_h__*/
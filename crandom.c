@@ -9,10 +9,13 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "counters.h"
 #include "crandom.h"
 #include "dSFMT/dSFMT.h"
+#include "probes.h"
 
 
 /**
@@ -34,6 +37,11 @@ struct dSFMTRandom {
 double dSFMTRandomNext(void * that) {
   struct dSFMTRandom * random = (struct dSFMTRandom *) that;
 
+  CRANDOM_COUNT(CRANDOM_UNIFORMS, 1);
+  CRANDOM_COUNT(CRANDOM_REFILLS, random->dsfmt.idx >= DSFMT_N64);
+  if( CRANDOM_PROBE_ENABLED(refill) && random->dsfmt.idx >= DSFMT_N64 )
+    CRANDOM_PROBE2(refill, random, 1);
+
   return dsfmt_genrand_close_open(&random->dsfmt);
 }
 
@@ -78,6 +86,47 @@ struct cRandom * dSFMTRandomNewByArray(int * array, int arrayLength) {
 }
 
 
+/**
+ * Reinitialize a cRandom object created by dSFMTRandomNew* by array.
+ */
+void dSFMTRandomInitByArray(struct cRandom * crandom, int * array, int arrayLength) {
+  struct dSFMTRandom * random = (struct dSFMTRandom *) crandom;
+
+  assert( crandom->next == &dSFMTRandomNext );
+
+  dsfmt_init_by_array(&random->dsfmt, (uint32_t*)array, (arrayLength * sizeof(int)) / sizeof(uint32_t));
+}
+
+
+/**
+ * Create a copy of a cRandom object created by dSFMTRandomNew*
+ */
+struct cRandom * dSFMTRandomClone(const struct cRandom * crandom) {
+  struct dSFMTRandom * random;
+
+  assert( crandom->next == &dSFMTRandomNext );
+
+  random = (struct dSFMTRandom *) malloc(sizeof(*random));
+  if( random == NULL )
+    return NULL;
+
+  memcpy(random, crandom, sizeof(*random));
+  return (struct cRandom *)random;
+}
+
+
+/**
+ * Returns the dSFMT state of a cRandom object created by dSFMTRandomNew*
+ */
+void * dSFMTRandomState(struct cRandom * crandom) {
+  struct dSFMTRandom * random = (struct dSFMTRandom *) crandom;
+
+  assert( crandom->next == &dSFMTRandomNext );
+
+  return &random->dsfmt;
+}
+
+
 /**
  * Create a new cRandom object (dSFMT based)
  */
@@ -101,9 +150,11 @@ struct cRandom * dSFMTRandomNew(void) {
  * Variance: p * (1 - p)
  */
 int bernoulli(struct cRandom * crandom, double p) {
+  CRANDOM_COUNT(CRANDOM_BERNOULLI, 1);
+
   assert( 0.0 < p && p < 1.0 );
 
-  return (crandom->next(crandom) > p);
+  return (crandom->next(crandom) < p);
 }
 
 
@@ -118,11 +169,13 @@ int bernoulli(struct cRandom * crandom, double p) {
 int binomial(struct cRandom * crandom, int n, double p) {
   int i, x = 0;
 
+  CRANDOM_COUNT(CRANDOM_BINOMIAL, 1);
+
   assert( 0 < n );
   assert( 0.0 < p && p < 1.0 );
 
   for(i = 0; i < n; ++i)
-    x += (crandom->next(crandom) > p); /* x += Bernoulli(crandom, p); */
+    x += (crandom->next(crandom) < p); /* x += Bernoulli(crandom, p); */
 
   return x;
 }
@@ -137,6 +190,8 @@ int binomial(struct cRandom * crandom, int n, double p) {
  * Variance: (sqr(b - a + 1) - 1) / 12
  */
 int equilikely(struct cRandom * crandom, int a, int b) {
+  CRANDOM_COUNT(CRANDOM_EQUILIKELY, 1);
+
   assert( a < b );
 
   return (a + (int) ((b - a + 1) * crandom->next(crandom)));
@@ -152,6 +207,8 @@ int equilikely(struct cRandom * crandom, int a, int b) {
  * Variance: p / sqr(1 - p)
  */
 int geometric(struct cRandom * crandom, double p) {
+  CRANDOM_COUNT(CRANDOM_GEOMETRIC, 1);
+
   assert( 0.0 < p && p < 1.0 );
 
   return ((int) (log(1.0 - crandom->next(crandom)) / log(p)));
@@ -170,6 +227,8 @@ int pascal(struct cRandom * crandom, int n, double p) {
   const double log_p = log(p);
   int i, x = 0;
 
+  CRANDOM_COUNT(CRANDOM_PASCAL, 1);
+
   assert( 0 < n );
   assert( 0.0 < p && p < 1.0 );
 
@@ -192,13 +251,19 @@ int Poisson(struct cRandom * crandom, double m) {
   double t = 0.0;
   int x = -1;
 
+  CRANDOM_COUNT(CRANDOM_POISSON, 1);
+
   assert( 0.0 < m );
 
   while (t < m) {
-    t -= m * log(1.0 - crandom->next(crandom)); /* t += exponential(crandom, 1.0); */
+    t -= log(1.0 - crandom->next(crandom)); /* t += exponential(crandom, 1.0); */
     x++;
   }
 
+  CRANDOM_COUNT(CRANDOM_POISSON_ITERATIONS, x + 1);
+  if( CRANDOM_PROBE_ENABLED(poisson_loop) && x + 1 > CRANDOM_PROBE_LOOP )
+    CRANDOM_PROBE2(poisson_loop, x + 1, CRANDOM_PROBE_MICRO(m));
+
   return x;
 }
 
@@ -217,6 +282,8 @@ int Poisson(struct cRandom * crandom, double m) {
  * Variance: sqr(b - a) / 12 
  */
 double uniform(struct cRandom * crandom, double a, double b) {
+  CRANDOM_COUNT(CRANDOM_UNIFORM, 1);
+
   assert( a < b );
 
   return a + (b - a) * crandom->next(crandom);
@@ -232,9 +299,17 @@ double uniform(struct cRandom * crandom, double a, double b) {
  * Variance: sqr(m)
  */
 double exponential(struct cRandom * crandom, double m) {
+  double z;
+
+  CRANDOM_COUNT(CRANDOM_EXPONENTIAL, 1);
+
   assert( 0.0 < m );
 
-  return - m * log(1.0 - crandom->next(crandom));
+  z = - log(1.0 - crandom->next(crandom));
+  if( CRANDOM_PROBE_ENABLED(exponential_tail) && z >= CRANDOM_PROBE_EXPONENTIAL_TAIL )
+    CRANDOM_PROBE2(exponential_tail, crandom, CRANDOM_PROBE_MICRO(z));
+
+  return m * z;
 }
 
 
@@ -250,6 +325,8 @@ double erlang(struct cRandom * crandom, int n, double b) {
   int i;
   double x = 0.0;
 
+  CRANDOM_COUNT(CRANDOM_ERLANG, 1);
+
   assert( 0 < n );
   assert( 0.0 < b );
 
@@ -261,6 +338,33 @@ double erlang(struct cRandom * crandom, int n, double b) {
 }
 
 
+/**
+ * Returns the standard normal idf at u, 0 <= u < 1.
+ *
+ * Uses a very accurate approximation of the normal idf due to Odeh & Evans, 
+ * J. Applied Statistics, 1974, vol 23, pp 96-97.
+ *
+ * The branches are expressed as selections so that loops over this
+ * function can be vectorized.
+ */
+static double normal_idf(double u) {
+  const double p0 = 0.322232431088;     const double q0 = 0.099348462606;
+  const double p1 = 1.0;                const double q1 = 0.588581570495;
+  const double p2 = 0.342242088547;     const double q2 = 0.531103462366;
+  const double p3 = 0.204231210245e-1;  const double q3 = 0.103537752850;
+  const double p4 = 0.453642210148e-4;  const double q4 = 0.385607006340e-2;
+  double v, t, p, q, z;
+
+  v = (u < 0.5) ? u : 1.0 - u;
+  t = sqrt(-2.0 * log(v));
+  p = p0 + t * (p1 + t * (p2 + t * (p3 + t * p4)));
+  q = q0 + t * (q1 + t * (q2 + t * (q3 + t * q4)));
+  z = (p / q) - t;
+
+  return (u < 0.5) ? z : -z;
+}
+
+
 /**
  * Returns a normal (Gaussian) distributed real number.
  * NOTE: use s > 0.0
@@ -270,30 +374,15 @@ double erlang(struct cRandom * crandom, int n, double b) {
  * Variance: sqr(s)
  */
 double normal(struct cRandom * crandom, double m, double s) {
-  /*
-   * Uses a very accurate approximation of the normal idf due to Odeh & Evans, 
-   * J. Applied Statistics, 1974, vol 23, pp 96-97.
-   */
-  const double p0 = 0.322232431088;     const double q0 = 0.099348462606;
-  const double p1 = 1.0;                const double q1 = 0.588581570495;
-  const double p2 = 0.342242088547;     const double q2 = 0.531103462366;
-  const double p3 = 0.204231210245e-1;  const double q3 = 0.103537752850;
-  const double p4 = 0.453642210148e-4;  const double q4 = 0.385607006340e-2;
-  double u, t, p, q, z;
+  double z;
+
+  CRANDOM_COUNT(CRANDOM_NORMAL, 1);
 
   assert( 0.0 < s );
 
-  u = crandom->next(crandom);
-  if( u < 0.5 )
-    t = sqrt(-2.0 * log(u));
-  else
-    t = sqrt(-2.0 * log(1.0 - u));
-  p   = p0 + t * (p1 + t * (p2 + t * (p3 + t * p4)));
-  q   = q0 + t * (q1 + t * (q2 + t * (q3 + t * q4)));
-  if( u < 0.5 )
-    z = (p / q) - t;
-  else
-    z = t - (p / q);
+  z = normal_idf(crandom->next(crandom));
+  if( CRANDOM_PROBE_ENABLED(normal_tail) && fabs(z) >= CRANDOM_PROBE_NORMAL_TAIL )
+    CRANDOM_PROBE2(normal_tail, crandom, CRANDOM_PROBE_MICRO(z));
 
   return (m + s * z);
 }
@@ -308,6 +397,8 @@ double normal(struct cRandom * crandom, double m, double s) {
  * Variance: (exp(sqr(b) - 1) * exp(2 * a + sqr(b))
  */
 double lognormal(struct cRandom * crandom, double a, double b) {
+  CRANDOM_COUNT(CRANDOM_LOGNORMAL, 1);
+
   assert( 0.0 < b );
 
   return (exp(a + b * normal(crandom, 0.0, 1.0)));
@@ -326,6 +417,8 @@ double chisquare(struct cRandom * crandom, int n) {
   long   i;
   double z, x = 0.0;
 
+  CRANDOM_COUNT(CRANDOM_CHISQUARE, 1);
+
   assert( 0 < n );
 
   for (i = 0; i < n; ++i) {
@@ -347,6 +440,8 @@ double chisquare(struct cRandom * crandom, int n) {
  * Variance: n / (n - 2) (when n > 2)
  */
 double student(struct cRandom * crandom, int n) {
+  CRANDOM_COUNT(CRANDOM_STUDENT, 1);
+
   assert( 0 < n );
 
   return (normal(crandom, 0.0, 1.0) / sqrt(chisquare(crandom, n) / n));
@@ -363,8 +458,123 @@ double student(struct cRandom * crandom, int n) {
  * Variance: existed  (when k < -2)
  */
 double power_law(struct cRandom * crandom, double k, double c) {
+    CRANDOM_COUNT(CRANDOM_POWER_LAW, 1);
+
     assert( k < -1.0 && 0 < c );
 
     return exp( (k + 1) * log((crandom->next(crandom) - 1.0) * (k + 1) / c) );
 }
 
+
+
+/***************
+ * Batch forms *
+ ***************/
+
+
+/**
+ * Fills array with values of crandom->next.
+ *
+ * Range: 0 <= x < 1
+ */
+void random_fill(struct cRandom * crandom, double * array, size_t size) {
+  size_t i;
+
+  CRANDOM_COUNT(CRANDOM_RANDOM_FILL, 1);
+
+  if( crandom->next == &dSFMTRandomNext ) {
+    /* Copy straight out of the dSFMT state, one block at a time */
+    dsfmt_t * dsfmt = &((struct dSFMTRandom *) crandom)->dsfmt;
+    const double * psfmt64 = &dsfmt->status[0].d[0];
+    size_t k;
+
+    CRANDOM_COUNT(CRANDOM_UNIFORMS, size);
+    while( size > 0 ) {
+      if( dsfmt->idx >= DSFMT_N64 ) {
+        CRANDOM_COUNT(CRANDOM_REFILLS, 1);
+        if( CRANDOM_PROBE_ENABLED(refill) )
+          CRANDOM_PROBE2(refill, crandom, size);
+        dsfmt_gen_rand_all(dsfmt);
+        dsfmt->idx = 0;
+      }
+      k = DSFMT_N64 - dsfmt->idx;
+      if( size < k )
+        k = size;
+      for(i = 0; i < k; ++i)
+        array[i] = psfmt64[dsfmt->idx + i] - 1.0;
+      dsfmt->idx += (int) k;
+      array += k;
+      size -= k;
+    }
+    return;
+  }
+
+  for(i = 0; i < size; ++i)
+    array[i] = crandom->next(crandom);
+}
+
+
+/**
+ * Fills array with uniformly distributed real numbers between a and b.
+ * NOTE: use a < b
+ */
+void uniform_fill(struct cRandom * crandom, double a, double b, double * array, size_t size) {
+  size_t i;
+
+  CRANDOM_COUNT(CRANDOM_UNIFORM_FILL, 1);
+
+  assert( a < b );
+
+  random_fill(crandom, array, size);
+  for(i = 0; i < size; ++i)
+    array[i] = a + (b - a) * array[i];
+}
+
+
+/**
+ * Fills array with exponentially distributed positive real numbers.
+ * NOTE: use m > 0.0
+ */
+void exponential_fill(struct cRandom * crandom, double m, double * array, size_t size) {
+  size_t i;
+
+  CRANDOM_COUNT(CRANDOM_EXPONENTIAL_FILL, 1);
+
+  assert( 0.0 < m );
+
+  random_fill(crandom, array, size);
+  for(i = 0; i < size; ++i)
+    array[i] = - m * log(1.0 - array[i]);
+
+  /* a separate pass keeps the loop above vectorizable */
+  if( CRANDOM_PROBE_ENABLED(exponential_tail) ) {
+    for(i = 0; i < size; ++i) {
+      if( array[i] >= CRANDOM_PROBE_EXPONENTIAL_TAIL * m )
+        CRANDOM_PROBE2(exponential_tail, crandom, CRANDOM_PROBE_MICRO(array[i] / m));
+    }
+  }
+}
+
+
+/**
+ * Fills array with normal (Gaussian) distributed real numbers.
+ * NOTE: use s > 0.0
+ */
+void normal_fill(struct cRandom * crandom, double m, double s, double * array, size_t size) {
+  size_t i;
+
+  CRANDOM_COUNT(CRANDOM_NORMAL_FILL, 1);
+
+  assert( 0.0 < s );
+
+  random_fill(crandom, array, size);
+  for(i = 0; i < size; ++i)
+    array[i] = m + s * normal_idf(array[i]);
+
+  if( CRANDOM_PROBE_ENABLED(normal_tail) ) {
+    for(i = 0; i < size; ++i) {
+      if( fabs(array[i] - m) >= CRANDOM_PROBE_NORMAL_TAIL * s )
+        CRANDOM_PROBE2(normal_tail, crandom, CRANDOM_PROBE_MICRO((array[i] - m) / s));
+    }
+  }
+}
@@ -9,6 +9,8 @@
 #ifndef __crandom_h__
 #define __crandom_h__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -56,6 +58,31 @@ struct cRandom * dSFMTRandomNewBySeed(int seed);
 struct cRandom * dSFMTRandomNewByArray(int * array, int arrayLength);
 
 
+/**
+ * Reinitialize a cRandom object created by dSFMTRandomNew* by array.
+ *
+ * The object then produces the same sequence as
+ * dSFMTRandomNewByArray(array, arrayLength), without a new allocation.
+ */
+void dSFMTRandomInitByArray(struct cRandom * crandom, int * array, int arrayLength);
+
+
+/**
+ * Create a copy of a cRandom object created by dSFMTRandomNew*; the copy
+ * continues the same sequence independently.
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct cRandom * dSFMTRandomClone(const struct cRandom * crandom);
+
+
+/**
+ * Returns the dSFMT state (dsfmt_t *) of a cRandom object created by
+ * dSFMTRandomNew*, e.g. for dSFMTRandomJump (jump.h).
+ */
+void * dSFMTRandomState(struct cRandom * crandom);
+
+
 
 
 /***********************
@@ -223,6 +250,46 @@ double student(struct cRandom * crandom, int n);
 double power_law(struct cRandom * crandom, double k, double c);
 
 
+/***************
+ * Batch forms *
+ ***************/
+
+/*
+ * The batch forms write size variates into array. They consume the
+ * underlying uniform sequence in the same order as size successive calls
+ * of the scalar form, so the results are identical to a scalar loop.
+ */
+
+
+/**
+ * Fills array with values of crandom->next.
+ *
+ * Range: 0 <= x < 1
+ */
+void random_fill(struct cRandom * crandom, double * array, size_t size);
+
+
+/**
+ * Fills array with uniformly distributed real numbers between a and b.
+ * NOTE: use a < b
+ */
+void uniform_fill(struct cRandom * crandom, double a, double b, double * array, size_t size);
+
+
+/**
+ * Fills array with exponentially distributed positive real numbers.
+ * NOTE: use m > 0.0
+ */
+void exponential_fill(struct cRandom * crandom, double m, double * array, size_t size);
+
+
+/**
+ * Fills array with normal (Gaussian) distributed real numbers.
+ * NOTE: use s > 0.0
+ */
+void normal_fill(struct cRandom * crandom, double m, double s, double * array, size_t size);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,330 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "des.h"
+
+
+/* Number of events allocated at once by the pool */
+#define DES_POOL_CHUNK (4096)
+
+
+/**
+ * Event with the bookkeeping of the pool and the calendar
+ */
+struct DesNode {
+  struct DesEvent event;   /* must be the first member */
+
+  size_t position;         /* index in the heap */
+  struct DesNode * next;   /* next free node */
+};
+
+
+/**
+ * Heap entry; the keys are kept in the heap itself, so sifting does not
+ * touch the event nodes except to update their positions.
+ */
+struct DesEntry {
+  double time;
+  size_t sequence;
+  struct DesNode * node;
+};
+
+
+struct DesChunk {
+  struct DesChunk * next;
+  struct DesNode nodes[DES_POOL_CHUNK];
+};
+
+
+struct DesSimulation {
+  double now;
+  size_t sequence;
+  int stopped;
+
+  DesHandler handler;
+  void * ctx;
+
+  /* 4-ary min-heap on (time, sequence) */
+  struct DesEntry * heap;
+  size_t size;
+  size_t capacity;
+
+  /* event pool */
+  struct DesChunk * chunks;
+  struct DesNode * free;
+
+  /* per-entity streams, created on first use */
+  int entities;
+  int seed;
+  struct cRandom ** streams;
+};
+
+
+static int entry_less(const struct DesEntry * lhs, const struct DesEntry * rhs) {
+  return lhs->time < rhs->time || (lhs->time == rhs->time && lhs->sequence < rhs->sequence);
+}
+
+
+static void sift_up(struct DesSimulation * sim, size_t i) {
+  struct DesEntry * heap = sim->heap;
+  struct DesEntry entry = heap[i];
+  size_t parent;
+
+  while( i > 0 ) {
+    parent = (i - 1) / 4;
+    if( !entry_less(&entry, &heap[parent]) )
+      break;
+    heap[i] = heap[parent];
+    heap[i].node->position = i;
+    i = parent;
+  }
+  heap[i] = entry;
+  entry.node->position = i;
+}
+
+
+static void sift_down(struct DesSimulation * sim, size_t i) {
+  struct DesEntry * heap = sim->heap;
+  struct DesEntry entry = heap[i];
+  const size_t size = sim->size;
+  size_t child, best, last;
+
+  for(;;) {
+    child = 4 * i + 1;
+    if( child >= size )
+      break;
+    last = child + 4 < size ? child + 4 : size;
+    best = child;
+    for(++child; child < last; ++child) {
+      if( entry_less(&heap[child], &heap[best]) )
+        best = child;
+    }
+    if( !entry_less(&heap[best], &entry) )
+      break;
+    heap[i] = heap[best];
+    heap[i].node->position = i;
+    i = best;
+  }
+  heap[i] = entry;
+  entry.node->position = i;
+}
+
+
+static struct DesNode * node_alloc(struct DesSimulation * sim) {
+  struct DesNode * node;
+  struct DesChunk * chunk;
+  int i;
+
+  if( sim->free == NULL ) {
+    chunk = (struct DesChunk *) malloc(sizeof(*chunk));
+    if( chunk == NULL )
+      return NULL;
+    chunk->next = sim->chunks;
+    sim->chunks = chunk;
+    for(i = DES_POOL_CHUNK - 1; i >= 0; --i) {
+      chunk->nodes[i].next = sim->free;
+      sim->free = &chunk->nodes[i];
+    }
+  }
+
+  node = sim->free;
+  sim->free = node->next;
+  return node;
+}
+
+
+static void node_free(struct DesSimulation * sim, struct DesNode * node) {
+  node->next = sim->free;
+  sim->free = node;
+}
+
+
+/**
+ * Create a new discrete-event simulation
+ */
+struct DesSimulation * DesSimulationNew(int entities, int seed, DesHandler handler, void * ctx) {
+  struct DesSimulation * sim;
+
+  assert( 0 <= entities );
+
+  sim = (struct DesSimulation *) calloc(1, sizeof(*sim));
+  if( sim == NULL )
+    return NULL;
+
+  sim->handler = handler;
+  sim->ctx = ctx;
+  sim->entities = entities;
+  sim->seed = seed;
+
+  sim->capacity = 1024;
+  sim->heap = (struct DesEntry *) malloc(sim->capacity * sizeof(struct DesEntry));
+  sim->streams = (struct cRandom **) calloc(entities > 0 ? entities : 1, sizeof(struct cRandom *));
+  if( sim->heap == NULL || sim->streams == NULL ) {
+    DesSimulationRelease(sim);
+    return NULL;
+  }
+
+  return sim;
+}
+
+
+/**
+ * Releases resources of a DesSimulation object
+ */
+void DesSimulationRelease(struct DesSimulation * sim) {
+  struct DesChunk * chunk;
+  int i;
+
+  if( sim == NULL )
+    return;
+
+  while( sim->chunks != NULL ) {
+    chunk = sim->chunks;
+    sim->chunks = chunk->next;
+    free(chunk);
+  }
+
+  if( sim->streams != NULL ) {
+    for(i = 0; i < sim->entities; ++i) {
+      if( sim->streams[i] != NULL )
+        sim->streams[i]->release(sim->streams[i]);
+    }
+  }
+
+  free(sim->streams);
+  free(sim->heap);
+  free(sim);
+}
+
+
+/**
+ * Returns the current simulation time
+ */
+double DesNow(const struct DesSimulation * sim) {
+  return sim->now;
+}
+
+
+/**
+ * Returns the random stream of an entity
+ */
+struct cRandom * DesStream(struct DesSimulation * sim, int entity) {
+  int key[2];
+
+  assert( 0 <= entity && entity < sim->entities );
+
+  if( sim->streams[entity] == NULL ) {
+    key[0] = sim->seed;
+    key[1] = entity;
+    sim->streams[entity] = dSFMTRandomNewByArray(key, 2);
+  }
+
+  return sim->streams[entity];
+}
+
+
+/**
+ * Schedules an event at the given time
+ */
+struct DesEvent * DesSchedule(struct DesSimulation * sim, double time, int type, int entity, void * data) {
+  struct DesNode * node;
+  struct DesEntry * heap;
+
+  assert( sim->now <= time );
+
+  if( sim->size == sim->capacity ) {
+    heap = (struct DesEntry *) realloc(sim->heap, 2 * sim->capacity * sizeof(struct DesEntry));
+    if( heap == NULL )
+      return NULL;
+    sim->heap = heap;
+    sim->capacity *= 2;
+  }
+
+  node = node_alloc(sim);
+  if( node == NULL )
+    return NULL;
+
+  node->event.time = time;
+  node->event.type = type;
+  node->event.entity = entity;
+  node->event.data = data;
+
+  sim->heap[sim->size].time = time;
+  sim->heap[sim->size].sequence = sim->sequence++;
+  sim->heap[sim->size].node = node;
+  sift_up(sim, sim->size++);
+
+  return &node->event;
+}
+
+
+/**
+ * Removes the heap entry at position i
+ */
+static void heap_remove(struct DesSimulation * sim, size_t i) {
+  if( --sim->size == i )
+    return;
+
+  sim->heap[i] = sim->heap[sim->size];
+  if( i > 0 && entry_less(&sim->heap[i], &sim->heap[(i - 1) / 4]) )
+    sift_up(sim, i);
+  else
+    sift_down(sim, i);
+}
+
+
+/**
+ * Removes a pending event from the calendar
+ */
+void DesCancel(struct DesSimulation * sim, struct DesEvent * event) {
+  struct DesNode * node = (struct DesNode *) event;
+
+  assert( node->position < sim->size && sim->heap[node->position].node == node );
+
+  heap_remove(sim, node->position);
+  node_free(sim, node);
+}
+
+
+/**
+ * Returns the number of pending events
+ */
+size_t DesPending(const struct DesSimulation * sim) {
+  return sim->size;
+}
+
+
+/**
+ * Processes events in time order
+ */
+size_t DesRun(struct DesSimulation * sim, double until) {
+  struct DesNode * node;
+  size_t processed = 0;
+
+  sim->stopped = 0;
+  while( sim->size > 0 && !sim->stopped && sim->heap[0].time <= until ) {
+    node = sim->heap[0].node;
+    heap_remove(sim, 0);
+
+    sim->now = node->event.time;
+    sim->handler(sim, &node->event, sim->ctx);
+    node_free(sim, node);
+    ++processed;
+  }
+
+  return processed;
+}
+
+
+/**
+ * Makes DesRun return after the current event
+ */
+void DesStop(struct DesSimulation * sim) {
+  sim->stopped = 1;
+}
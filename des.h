@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __des_h__
+#define __des_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Scheduled event
+ */
+struct DesEvent {
+  double time;
+  int type;
+  int entity;
+  void * data;
+};
+
+
+/**
+ * Discrete-event simulation
+ */
+struct DesSimulation;
+
+
+/**
+ * Event handler. It may schedule and cancel events; the event itself is
+ * returned to the pool when the handler returns.
+ */
+typedef void (* DesHandler)(struct DesSimulation * sim, const struct DesEvent * event, void * ctx);
+
+
+/**
+ * Create a new discrete-event simulation
+ *
+ * Every entity 0, ..., entities - 1 has an own random stream (dSFMT based),
+ * initialized by the pair (seed, entity).
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct DesSimulation * DesSimulationNew(int entities, int seed, DesHandler handler, void * ctx);
+
+
+/**
+ * Releases resources of a DesSimulation object
+ */
+void DesSimulationRelease(struct DesSimulation * sim);
+
+
+/**
+ * Returns the current simulation time
+ */
+double DesNow(const struct DesSimulation * sim);
+
+
+/**
+ * Returns the random stream of an entity; it is created on the first call.
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct cRandom * DesStream(struct DesSimulation * sim, int entity);
+
+
+/**
+ * Schedules an event at the given time (not before DesNow).
+ * Events with equal times are processed in the scheduling order.
+ *
+ * Returns a handle for DesCancel, or NULL if there is not enough memory.
+ */
+struct DesEvent * DesSchedule(struct DesSimulation * sim, double time, int type, int entity, void * data);
+
+
+/**
+ * Removes a pending event from the calendar
+ */
+void DesCancel(struct DesSimulation * sim, struct DesEvent * event);
+
+
+/**
+ * Returns the number of pending events
+ */
+size_t DesPending(const struct DesSimulation * sim);
+
+
+/**
+ * Processes events in time order until the calendar is empty, the next
+ * event is later than until, or DesStop is called.
+ *
+ * Returns the number of processed events.
+ */
+size_t DesRun(struct DesSimulation * sim, double until);
+
+
+/**
+ * Makes DesRun return after the current event
+ */
+void DesStop(struct DesSimulation * sim);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__des_h__*/
@@ -0,0 +1,558 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "counters.h"
+#include "gillespie.h"
+#include "probes.h"
+
+
+/* Propensity a belongs to the group frexp-exponent(a) + SSA_GROUP_OFFSET */
+#define SSA_GROUP_OFFSET (1100)
+#define SSA_GROUPS (2200)
+
+/* Group sums are recomputed exactly after this number of events */
+#define SSA_REFRESH (65536)
+
+
+/**
+ * Reactions with propensities in [2^(e-1), 2^e)
+ */
+struct SsaGroup {
+  double sum;
+  int size;
+  int capacity;
+  int * members;
+};
+
+
+struct Gillespie {
+  int species;
+  int reactions;
+
+  double time;
+  long * x;
+
+  double * rate;
+  int * reactantStart;          /* CSR: reactant terms of reactions */
+  struct SsaTerm * reactants;
+  int * changeStart;            /* CSR: net changes (species, delta) */
+  struct SsaTerm * changes;
+  int * dependStart;            /* CSR: reactions to update after a reaction */
+  int * depends;
+
+  double * a;                   /* propensities */
+  int * group;                  /* group of a reaction or -1 */
+  int * slot;                   /* position in the group */
+
+  struct SsaGroup * groups;
+  int lo;                       /* range of groups ever used */
+  int hi;
+  int active;                   /* reactions in the groups */
+  double total;
+  int sinceRefresh;
+
+  long * scratch;               /* tau-leaping */
+};
+
+
+static double propensity(const struct Gillespie * ssa, int j) {
+  double a = ssa->rate[j];
+  long n;
+  int t, i;
+
+  for(t = ssa->reactantStart[j]; t < ssa->reactantStart[j + 1]; ++t) {
+    n = ssa->x[ssa->reactants[t].species];
+    if( n < ssa->reactants[t].count )
+      return 0.0;
+    for(i = 0; i < ssa->reactants[t].count; ++i)
+      a *= (double) (n - i) / (i + 1);
+  }
+
+  return a;
+}
+
+
+static int group_of(double a) {
+  int e;
+
+  if( !(a > 0.0) )
+    return -1;
+  frexp(a, &e);
+  return e + SSA_GROUP_OFFSET;
+}
+
+
+static int group_insert(struct Gillespie * ssa, int g, int j) {
+  struct SsaGroup * group = &ssa->groups[g];
+  int * members;
+
+  if( group->size == group->capacity ) {
+    members = (int *) realloc(group->members, (group->capacity ? 2 * group->capacity : 8) * sizeof(int));
+    if( members == NULL )
+      return 0;
+    group->members = members;
+    group->capacity = group->capacity ? 2 * group->capacity : 8;
+  }
+
+  ssa->slot[j] = group->size;
+  group->members[group->size++] = j;
+  group->sum += ssa->a[j];
+  ssa->active++;
+  ssa->group[j] = g;
+  if( g < ssa->lo )
+    ssa->lo = g;
+  if( g > ssa->hi )
+    ssa->hi = g;
+  return 1;
+}
+
+
+static void group_erase(struct Gillespie * ssa, int j) {
+  struct SsaGroup * group = &ssa->groups[ssa->group[j]];
+  int last = group->members[--group->size];
+
+  group->members[ssa->slot[j]] = last;
+  ssa->slot[last] = ssa->slot[j];
+  group->sum -= ssa->a[j];
+  ssa->group[j] = -1;
+  ssa->active--;
+}
+
+
+/**
+ * Recomputes the propensity of reaction j and moves it between groups
+ */
+static int update(struct Gillespie * ssa, int j) {
+  const double a = propensity(ssa, j);
+  const int g = group_of(a);
+
+  ssa->total += a - ssa->a[j];
+  if( g == ssa->group[j] ) {
+    if( g >= 0 )
+      ssa->groups[g].sum += a - ssa->a[j];
+    ssa->a[j] = a;
+    return 1;
+  }
+
+  if( ssa->group[j] >= 0 )
+    group_erase(ssa, j);
+  ssa->a[j] = a;
+  if( g >= 0 )
+    return group_insert(ssa, g, j);
+  return 1;
+}
+
+
+/**
+ * Recomputes group sums and the total propensity exactly
+ */
+static void refresh(struct Gillespie * ssa) {
+  struct SsaGroup * group;
+  int g, i;
+
+  ssa->total = 0.0;
+  for(g = ssa->lo; g <= ssa->hi; ++g) {
+    group = &ssa->groups[g];
+    group->sum = 0.0;
+    for(i = 0; i < group->size; ++i)
+      group->sum += ssa->a[group->members[i]];
+    ssa->total += group->sum;
+  }
+  ssa->sinceRefresh = 0;
+}
+
+
+/**
+ * Builds the dependency graph: reaction k depends on reaction j if
+ * one of the reactants of k is changed by j
+ */
+static int build_depends(struct Gillespie * ssa) {
+  const int S = ssa->species;
+  const int R = ssa->reactions;
+  int * consumerStart = (int *) calloc(S + 1, sizeof(int));
+  int * consumers = (int *) malloc((ssa->reactantStart[R] + 1) * sizeof(int));
+  int * mark = (int *) malloc((R > 0 ? R : 1) * sizeof(int));
+  int * list = (int *) malloc((R > 0 ? R : 1) * sizeof(int));
+  int * depends = NULL;
+  int size = 0, capacity = 0, count, s, t, c, j, k, ok = 0;
+
+  ssa->dependStart = (int *) malloc((R + 1) * sizeof(int));
+  if( consumerStart == NULL || consumers == NULL || mark == NULL || list == NULL || ssa->dependStart == NULL )
+    goto done;
+
+  /* species -> reactions consuming it */
+  for(t = 0; t < ssa->reactantStart[R]; ++t)
+    consumerStart[ssa->reactants[t].species + 1]++;
+  for(s = 0; s < S; ++s)
+    consumerStart[s + 1] += consumerStart[s];
+  for(j = 0; j < R; ++j) {
+    for(t = ssa->reactantStart[j]; t < ssa->reactantStart[j + 1]; ++t) {
+      s = ssa->reactants[t].species;
+      consumers[consumerStart[s]++] = j;
+    }
+  }
+  for(s = S; s > 0; --s)
+    consumerStart[s] = consumerStart[s - 1];
+  consumerStart[0] = 0;
+
+  for(j = 0; j < R; ++j)
+    mark[j] = -1;
+
+  for(j = 0; j < R; ++j) {
+    ssa->dependStart[j] = size;
+    count = 0;
+    for(t = ssa->changeStart[j]; t < ssa->changeStart[j + 1]; ++t) {
+      s = ssa->changes[t].species;
+      for(c = consumerStart[s]; c < consumerStart[s + 1]; ++c) {
+        k = consumers[c];
+        if( mark[k] != j ) {
+          mark[k] = j;
+          list[count++] = k;
+        }
+      }
+    }
+    if( size + count > capacity ) {
+      int * grown = (int *) realloc(depends, (2 * (size + count) + 1) * sizeof(int));
+      if( grown == NULL )
+        goto done;
+      depends = grown;
+      capacity = 2 * (size + count) + 1;
+    }
+    memcpy(depends + size, list, count * sizeof(int));
+    size += count;
+  }
+  ssa->dependStart[R] = size;
+  ssa->depends = depends;
+  depends = NULL;
+  ok = 1;
+
+done:
+  free(depends);
+  free(consumerStart);
+  free(consumers);
+  free(mark);
+  free(list);
+  return ok;
+}
+
+
+/**
+ * Create a new simulation with the initial molecule counts
+ */
+struct Gillespie * GillespieNew(int species, int reactions, const struct SsaReaction * reactionList, const long * initial) {
+  struct Gillespie * ssa;
+  long * delta;
+  int nReactants = 0, nChanges = 0, j, t, s;
+
+  assert( 0 < species && 0 < reactions );
+
+  ssa = (struct Gillespie *) calloc(1, sizeof(*ssa));
+  if( ssa == NULL )
+    return NULL;
+
+  ssa->species = species;
+  ssa->reactions = reactions;
+  ssa->lo = SSA_GROUPS;
+  ssa->hi = -1;
+
+  for(j = 0; j < reactions; ++j) {
+    nReactants += reactionList[j].reactantCount;
+    nChanges += reactionList[j].reactantCount + reactionList[j].productCount;
+  }
+
+  ssa->x = (long *) malloc(species * sizeof(long));
+  ssa->scratch = (long *) malloc(species * sizeof(long));
+  ssa->rate = (double *) malloc(reactions * sizeof(double));
+  ssa->reactantStart = (int *) malloc((reactions + 1) * sizeof(int));
+  ssa->reactants = (struct SsaTerm *) malloc((nReactants + 1) * sizeof(struct SsaTerm));
+  ssa->changeStart = (int *) malloc((reactions + 1) * sizeof(int));
+  ssa->changes = (struct SsaTerm *) malloc((nChanges + 1) * sizeof(struct SsaTerm));
+  ssa->a = (double *) calloc(reactions, sizeof(double));
+  ssa->group = (int *) malloc(reactions * sizeof(int));
+  ssa->slot = (int *) malloc(reactions * sizeof(int));
+  ssa->groups = (struct SsaGroup *) calloc(SSA_GROUPS, sizeof(struct SsaGroup));
+  delta = (long *) calloc(species, sizeof(long));
+  if( ssa->x == NULL || ssa->scratch == NULL || ssa->rate == NULL || ssa->reactantStart == NULL ||
+      ssa->reactants == NULL || ssa->changeStart == NULL || ssa->changes == NULL || ssa->a == NULL ||
+      ssa->group == NULL || ssa->slot == NULL || ssa->groups == NULL || delta == NULL )
+    goto failure;
+
+  memcpy(ssa->x, initial, species * sizeof(long));
+
+  nReactants = nChanges = 0;
+  for(j = 0; j < reactions; ++j) {
+    const struct SsaReaction * reaction = &reactionList[j];
+
+    assert( 0.0 <= reaction->rate );
+    ssa->rate[j] = reaction->rate;
+    ssa->group[j] = -1;
+
+    ssa->reactantStart[j] = nReactants;
+    for(t = 0; t < reaction->reactantCount; ++t) {
+      assert( 0 <= reaction->reactants[t].species && reaction->reactants[t].species < species );
+      ssa->reactants[nReactants++] = reaction->reactants[t];
+      delta[reaction->reactants[t].species] -= reaction->reactants[t].count;
+    }
+    for(t = 0; t < reaction->productCount; ++t) {
+      assert( 0 <= reaction->products[t].species && reaction->products[t].species < species );
+      delta[reaction->products[t].species] += reaction->products[t].count;
+    }
+
+    /* net changes; delta is cleared on the way */
+    ssa->changeStart[j] = nChanges;
+    for(t = 0; t < reaction->reactantCount + reaction->productCount; ++t) {
+      s = (t < reaction->reactantCount) ? reaction->reactants[t].species
+                                        : reaction->products[t - reaction->reactantCount].species;
+      if( delta[s] != 0 ) {
+        ssa->changes[nChanges].species = s;
+        ssa->changes[nChanges].count = (int) delta[s];
+        ++nChanges;
+        delta[s] = 0;
+      }
+    }
+  }
+  ssa->reactantStart[reactions] = nReactants;
+  ssa->changeStart[reactions] = nChanges;
+  free(delta);
+  delta = NULL;
+
+  if( !build_depends(ssa) )
+    goto failure;
+
+  for(j = 0; j < reactions; ++j) {
+    if( !update(ssa, j) )
+      goto failure;
+  }
+  refresh(ssa);
+
+  return ssa;
+
+failure:
+  free(delta);
+  GillespieRelease(ssa);
+  return NULL;
+}
+
+
+/**
+ * Releases resources of a Gillespie object
+ */
+void GillespieRelease(struct Gillespie * ssa) {
+  int g;
+
+  if( ssa == NULL )
+    return;
+
+  if( ssa->groups != NULL ) {
+    for(g = 0; g < SSA_GROUPS; ++g)
+      free(ssa->groups[g].members);
+  }
+  free(ssa->groups);
+  free(ssa->slot);
+  free(ssa->group);
+  free(ssa->a);
+  free(ssa->depends);
+  free(ssa->dependStart);
+  free(ssa->changes);
+  free(ssa->changeStart);
+  free(ssa->reactants);
+  free(ssa->reactantStart);
+  free(ssa->rate);
+  free(ssa->scratch);
+  free(ssa->x);
+  free(ssa);
+}
+
+
+/**
+ * Returns the current time
+ */
+double GillespieTime(const struct Gillespie * ssa) {
+  return ssa->time;
+}
+
+
+/**
+ * Returns the current molecule counts
+ */
+const long * GillespieState(const struct Gillespie * ssa) {
+  return ssa->x;
+}
+
+
+/**
+ * Returns 0 if all propensities are zero. The incremental total may keep
+ * a rounding residue after the last reaction has left the groups, so it
+ * is recomputed then.
+ */
+static int alive(struct Gillespie * ssa) {
+  if( ssa->active == 0 || !(ssa->total > 0.0) )
+    refresh(ssa);
+  return ssa->active > 0 && ssa->total > 0.0;
+}
+
+
+/**
+ * Selects a reaction with probability proportional to its propensity:
+ * a group by linear search over the group sums, then a member of the
+ * group by rejection against the group bound 2^e.
+ *
+ * Returns -1 if all propensities are zero.
+ */
+static int select_reaction(struct Gillespie * ssa, struct cRandom * crandom) {
+  struct SsaGroup * group;
+  double r, bound, v;
+  int g, i, tries = 0;
+
+  for(;;) {
+    group = NULL;
+    r = ssa->total * crandom->next(crandom);
+    for(g = ssa->hi; g >= ssa->lo; --g) {
+      if( ssa->groups[g].size == 0 )
+        continue;
+      group = &ssa->groups[g];
+      if( r < group->sum )
+        break;
+      r -= group->sum;
+    }
+    if( group != NULL && group->size > 0 )
+      break;
+    /* rounding residue in the sums; no group left means a dead system */
+    refresh(ssa);
+    if( !(ssa->total > 0.0) )
+      return -1;
+  }
+
+  g = (int) (group - ssa->groups);
+  bound = ldexp(1.0, g - SSA_GROUP_OFFSET);
+  for(;;) {
+    /* the fraction of v is an independent uniform for the acceptance */
+    v = group->size * crandom->next(crandom);
+    i = (int) v;
+    if( (v - i) * bound < ssa->a[group->members[i]] ) {
+      if( CRANDOM_PROBE_ENABLED(gillespie_loop) && tries + 1 > CRANDOM_PROBE_LOOP )
+        CRANDOM_PROBE2(gillespie_loop, tries + 1, g - SSA_GROUP_OFFSET);
+      return group->members[i];
+    }
+    CRANDOM_COUNT(CRANDOM_GILLESPIE_REJECTIONS, 1);
+    ++tries;
+  }
+}
+
+
+/**
+ * Applies reaction j and updates the dependent propensities, returns 0 if
+ * there is not enough memory
+ */
+static int fire(struct Gillespie * ssa, int j) {
+  int t;
+
+  for(t = ssa->changeStart[j]; t < ssa->changeStart[j + 1]; ++t)
+    ssa->x[ssa->changes[t].species] += ssa->changes[t].count;
+
+  for(t = ssa->dependStart[j]; t < ssa->dependStart[j + 1]; ++t) {
+    if( !update(ssa, ssa->depends[t]) )
+      return 0;
+  }
+
+  if( ++ssa->sinceRefresh >= SSA_REFRESH )
+    refresh(ssa);
+  return 1;
+}
+
+
+/**
+ * Fires the next reaction (direct method)
+ */
+int GillespieStep(struct Gillespie * ssa, struct cRandom * crandom) {
+  int j;
+
+  if( !alive(ssa) )
+    return -1;
+
+  ssa->time += exponential(crandom, 1.0 / ssa->total);
+  j = select_reaction(ssa, crandom);
+  if( j < 0 )
+    return -1;
+  if( !fire(ssa, j) )
+    return -2;
+  return j;
+}
+
+
+/**
+ * Fires reactions until the time until is reached
+ */
+size_t GillespieRun(struct Gillespie * ssa, struct cRandom * crandom, double until) {
+  size_t fired = 0;
+  double dt;
+  int j;
+
+  for(;;) {
+    if( !alive(ssa) )
+      break;
+
+    dt = exponential(crandom, 1.0 / ssa->total);
+    if( ssa->time + dt > until )
+      break;
+    ssa->time += dt;
+    j = select_reaction(ssa, crandom);
+    if( j < 0 )
+      break;
+    if( !fire(ssa, j) )
+      return (size_t) -1;
+    ++fired;
+  }
+
+  if( ssa->time < until )
+    ssa->time = until;
+  return fired;
+}
+
+
+/**
+ * Makes one tau-leap
+ */
+double GillespieTauLeap(struct Gillespie * ssa, struct cRandom * crandom, double tau) {
+  long * y = ssa->scratch;
+  long k;
+  int j, t, s, negative;
+
+  assert( 0.0 < tau );
+
+  for(;;) {
+    memcpy(y, ssa->x, ssa->species * sizeof(long));
+    for(j = 0; j < ssa->reactions; ++j) {
+      if( !(ssa->a[j] > 0.0) )
+        continue;
+      k = Poisson(crandom, ssa->a[j] * tau);
+      for(t = ssa->changeStart[j]; t < ssa->changeStart[j + 1]; ++t)
+        y[ssa->changes[t].species] += k * ssa->changes[t].count;
+    }
+
+    negative = 0;
+    for(s = 0; s < ssa->species; ++s)
+      negative |= (y[s] < 0);
+    if( !negative )
+      break;
+    tau *= 0.5;
+  }
+
+  memcpy(ssa->x, y, ssa->species * sizeof(long));
+  ssa->time += tau;
+  for(j = 0; j < ssa->reactions; ++j) {
+    if( !update(ssa, j) )
+      return 0.0;
+  }
+  refresh(ssa);
+
+  return tau;
+}
@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __gillespie_h__
+#define __gillespie_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * count molecules of species
+ */
+struct SsaTerm {
+  int species;
+  int count;
+};
+
+
+/**
+ * Mass-action reaction: reactants -> products with rate constant rate.
+ *
+ * Propensity: rate * prod C(x[species], count) over the reactants
+ */
+struct SsaReaction {
+  double rate;
+
+  int reactantCount;
+  const struct SsaTerm * reactants;
+
+  int productCount;
+  const struct SsaTerm * products;
+};
+
+
+/**
+ * Stochastic simulation of a reaction network (Gillespie)
+ *
+ * The next reaction is selected by composition-rejection over propensity
+ * groups [2^k, 2^(k+1)), and after an event only the reactions depending
+ * on the changed species are updated (dependency graph).
+ */
+struct Gillespie;
+
+
+/**
+ * Create a new simulation with the initial molecule counts
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct Gillespie * GillespieNew(int species, int reactions, const struct SsaReaction * reactionList, const long * initial);
+
+
+/**
+ * Releases resources of a Gillespie object
+ */
+void GillespieRelease(struct Gillespie * ssa);
+
+
+/**
+ * Returns the current time
+ */
+double GillespieTime(const struct Gillespie * ssa);
+
+
+/**
+ * Returns the current molecule counts
+ */
+const long * GillespieState(const struct Gillespie * ssa);
+
+
+/**
+ * Fires the next reaction (direct method).
+ *
+ * Returns the index of the reaction, -1 if all propensities are zero or
+ * -2 if there is not enough memory.
+ *
+ * NOTE: after a failure the object can only be released.
+ */
+int GillespieStep(struct Gillespie * ssa, struct cRandom * crandom);
+
+
+/**
+ * Fires reactions until the time until is reached or all propensities
+ * are zero; the time is then set to until.
+ *
+ * Returns the number of fired reactions or (size_t) -1 if there is not
+ * enough memory.
+ *
+ * NOTE: after a failure the object can only be released.
+ */
+size_t GillespieRun(struct Gillespie * ssa, struct cRandom * crandom, double until);
+
+
+/**
+ * Makes one tau-leap: every reaction fires Poisson(propensity * tau) times.
+ * If some count would become negative the leap is retried with tau / 2.
+ *
+ * Returns the length of the leap made or 0.0 if there is not enough
+ * memory.
+ *
+ * NOTE: after a failure the object can only be released.
+ */
+double GillespieTauLeap(struct Gillespie * ssa, struct cRandom * crandom, double tau);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__gillespie_h__*/
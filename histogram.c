@@ -0,0 +1,235 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "histogram.h"
+
+
+/* Number of bin indices computed at once */
+#define HISTOGRAM_BLOCK (256)
+
+
+struct Histogram {
+  int bins;
+  double a;
+  double b;
+
+  size_t total;
+  size_t * counts;
+};
+
+
+/**
+ * Create a new empty histogram
+ */
+struct Histogram * HistogramNew(int bins, double a, double b) {
+  struct Histogram * histogram;
+
+  assert( 0 < bins );
+  assert( a < b );
+
+  histogram = (struct Histogram *) malloc(sizeof(*histogram));
+  if( histogram == NULL )
+    return NULL;
+
+  histogram->counts = (size_t *) calloc(bins + 1, sizeof(size_t));
+  if( histogram->counts == NULL ) {
+    free(histogram);
+    return NULL;
+  }
+
+  histogram->bins = bins;
+  histogram->a = a;
+  histogram->b = b;
+  histogram->total = 0;
+
+  return histogram;
+}
+
+
+/**
+ * Releases resources of a Histogram object
+ */
+void HistogramRelease(struct Histogram * histogram) {
+  if( histogram == NULL )
+    return;
+
+  free(histogram->counts);
+  free(histogram);
+}
+
+
+/**
+ * Resets all counters
+ */
+void HistogramClear(struct Histogram * histogram) {
+  memset(histogram->counts, 0, (histogram->bins + 1) * sizeof(size_t));
+  histogram->total = 0;
+}
+
+
+/**
+ * Adds one value
+ */
+void HistogramAdd(struct Histogram * histogram, double x) {
+  HistogramAddArray(histogram, &x, 1);
+}
+
+
+/**
+ * Adds size values
+ */
+void HistogramAddArray(struct Histogram * histogram, const double * array, size_t size) {
+  const double a = histogram->a;
+  const double b = histogram->b;
+  const double n = histogram->bins;
+  int index[HISTOGRAM_BLOCK];
+  size_t offset;
+  int i, block;
+
+  for(offset = 0; offset < size; offset += block) {
+    block = (size - offset < HISTOGRAM_BLOCK) ? (int) (size - offset) : HISTOGRAM_BLOCK;
+
+    /* selections only, so that the loop vectorizes; NaN goes to bin 0 */
+    for(i = 0; i < block; ++i) {
+      double x = array[offset + i];
+
+      x = (x >= a) ? x : a;
+      x = (x <= b) ? x : b;
+      index[i] = (int) (n * (x - a) / (b - a));
+    }
+
+    for(i = 0; i < block; ++i)
+      histogram->counts[index[i]]++;
+  }
+
+  histogram->total += size;
+}
+
+
+/**
+ * Adds the counters of source to histogram
+ */
+void HistogramMerge(struct Histogram * histogram, const struct Histogram * source) {
+  int i;
+
+  assert( histogram->bins == source->bins );
+  assert( histogram->a == source->a && histogram->b == source->b );
+
+  for(i = 0; i <= histogram->bins; ++i)
+    histogram->counts[i] += source->counts[i];
+  histogram->total += source->total;
+}
+
+
+/**
+ * Returns the number of bins
+ */
+int HistogramBins(const struct Histogram * histogram) {
+  return histogram->bins;
+}
+
+
+/**
+ * Returns the left end of the range
+ */
+double HistogramLeft(const struct Histogram * histogram) {
+  return histogram->a;
+}
+
+
+/**
+ * Returns the right end of the range
+ */
+double HistogramRight(const struct Histogram * histogram) {
+  return histogram->b;
+}
+
+
+/**
+ * Returns the counter of bin i
+ */
+size_t HistogramCount(const struct Histogram * histogram, int i) {
+  assert( 0 <= i && i <= histogram->bins );
+
+  return histogram->counts[i];
+}
+
+
+/**
+ * Returns the number of added values
+ */
+size_t HistogramTotal(const struct Histogram * histogram) {
+  return histogram->total;
+}
+
+
+/**
+ * Stores the density estimate of every bin
+ */
+void HistogramDensity(const struct Histogram * histogram, double * density) {
+  const double scale = histogram->total > 0 ? histogram->bins / ((double) histogram->total * (histogram->b - histogram->a)) : 0.0;
+  int i;
+
+  for(i = 0; i <= histogram->bins; ++i)
+    density[i] = (double) histogram->counts[i] * scale;
+}
+
+
+/**
+ * Returns the left edge of bin i
+ */
+static double edge(const struct Histogram * histogram, int i) {
+  return histogram->a + ((double) i) * (histogram->b - histogram->a) / histogram->bins;
+}
+
+
+/**
+ * Returns the density of bin i, as test.c computes it
+ */
+static double density(const struct Histogram * histogram, int i) {
+  return ((double) histogram->counts[i]) * histogram->bins / (histogram->total * (histogram->b - histogram->a));
+}
+
+
+/**
+ * Writes "x density" lines for the non-empty bins
+ */
+int HistogramWriteText(const struct Histogram * histogram, FILE * file) {
+  int i;
+
+  for(i = 0; i <= histogram->bins; ++i) {
+    if( histogram->counts[i] ) {
+      if( fprintf(file, "%.3f %.3f\n", edge(histogram, i), density(histogram, i)) < 0 )
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+/**
+ * Writes (x, density) pairs as native doubles
+ */
+int HistogramWriteBinary(const struct Histogram * histogram, FILE * file) {
+  double pair[2];
+  int i;
+
+  for(i = 0; i <= histogram->bins; ++i) {
+    if( histogram->counts[i] ) {
+      pair[0] = edge(histogram, i);
+      pair[1] = density(histogram, i);
+      if( fwrite(pair, sizeof(double), 2, file) != 2 )
+        return 0;
+    }
+  }
+
+  return 1;
+}
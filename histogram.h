@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __histogram_h__
+#define __histogram_h__
+
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Histogram on [a, b] with bins equal bins
+ *
+ * As in test.c, a value x is clamped to [a, b] and counted in the bin
+ * floor(bins * (x - a) / (b - a)); the extra bin bins holds x = b (and
+ * everything above), so there are bins + 1 counters.
+ */
+struct Histogram;
+
+
+/**
+ * Create a new empty histogram
+ * NOTE: use bins > 0, a < b
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct Histogram * HistogramNew(int bins, double a, double b);
+
+
+/**
+ * Releases resources of a Histogram object
+ */
+void HistogramRelease(struct Histogram * histogram);
+
+
+/**
+ * Resets all counters
+ */
+void HistogramClear(struct Histogram * histogram);
+
+
+/**
+ * Adds one value
+ */
+void HistogramAdd(struct Histogram * histogram, double x);
+
+
+/**
+ * Adds size values, e.g. the output of one of the *_fill functions.
+ * Bin indices are computed in blocks by a branch-free loop.
+ */
+void HistogramAddArray(struct Histogram * histogram, const double * array, size_t size);
+
+
+/**
+ * Adds the counters of source to histogram
+ * NOTE: both must have the same bins, a and b
+ */
+void HistogramMerge(struct Histogram * histogram, const struct Histogram * source);
+
+
+/**
+ * Returns the number of bins (without the extra one)
+ */
+int HistogramBins(const struct Histogram * histogram);
+
+
+/**
+ * Returns the left end a of the range
+ */
+double HistogramLeft(const struct Histogram * histogram);
+
+
+/**
+ * Returns the right end b of the range
+ */
+double HistogramRight(const struct Histogram * histogram);
+
+
+/**
+ * Returns the counter of bin i, 0 <= i <= bins
+ */
+size_t HistogramCount(const struct Histogram * histogram, int i);
+
+
+/**
+ * Returns the number of added values
+ */
+size_t HistogramTotal(const struct Histogram * histogram);
+
+
+/**
+ * Stores the density estimate of every bin, bins + 1 values:
+ * count * bins / (total * (b - a)).
+ */
+void HistogramDensity(const struct Histogram * histogram, double * density);
+
+
+/**
+ * Writes "x density" lines for the non-empty bins, x being the left edge
+ * of the bin, in the format of test.c.
+ *
+ * Returns 0 on an output error, 1 otherwise.
+ */
+int HistogramWriteText(const struct Histogram * histogram, FILE * file);
+
+
+/**
+ * Writes the same (x, density) pairs as HistogramWriteText as native
+ * doubles, two per non-empty bin.
+ *
+ * Returns 0 on an output error, 1 otherwise.
+ */
+int HistogramWriteBinary(const struct Histogram * histogram, FILE * file);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__histogram_h__*/
@@ -0,0 +1,332 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+/*
+ * Jump-ahead for dSFMT.
+ *
+ * One block transition T (dsfmt_gen_rand_all) is linear over GF(2) on the
+ * whole state, the lung included. If p is a polynomial with p(T) = 0 then
+ * T^k = q(T), where q = x^k mod p, and q(T) s is evaluated by the Horner
+ * scheme with deg(p) block transitions (Haramoto et al., "Efficient jump
+ * ahead for F2-linear random number generators", 2008).
+ *
+ * p is the minimal polynomial of one output bit of a generic state, found
+ * by Berlekamp-Massey from 2 * (DSFMT_N + 1) * 128 block transitions.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jump.h"
+
+
+/* Seed of the generic state used to find the minimal polynomial */
+#define JUMP_SEED (4357)
+
+/* Upper bound of the dimension of the state (status and lung) */
+#define JUMP_DIMENSION ((DSFMT_N + 1) * 128)
+
+
+static int degree;                 /* deg(p) */
+static int words;                  /* words of a polynomial of degree < deg(p) */
+static uint64_t * minimal;         /* p, degree + 1 coefficients */
+static uint64_t * top;             /* top[b] = b(x) * x^degree mod p, b < 256 */
+static uint16_t spread[256];       /* spread[b] = b(x)^2 */
+
+
+static int get_bit(const uint64_t * a, int i) {
+  return (int) ((a[i >> 6] >> (i & 63)) & 1);
+}
+
+
+/**
+ * dst ^= src << shift, src has n words
+ */
+static void xor_shifted(uint64_t * dst, const uint64_t * src, int n, int shift) {
+  const int ws = shift >> 6;
+  const int bs = shift & 63;
+  int i;
+
+  if( bs == 0 ) {
+    for(i = 0; i < n; ++i)
+      dst[i + ws] ^= src[i];
+  } else {
+    for(i = 0; i < n; ++i) {
+      dst[i + ws] ^= src[i] << bs;
+      dst[i + ws + 1] ^= src[i] >> (64 - bs);
+    }
+  }
+}
+
+
+/**
+ * Returns 64 bits of a starting at bit offset
+ */
+static uint64_t get_word(const uint64_t * a, int offset) {
+  const int w = offset >> 6;
+  const int b = offset & 63;
+
+  if( b == 0 )
+    return a[w];
+  return (a[w] >> b) | (a[w + 1] << (64 - b));
+}
+
+
+static int parity(uint64_t x) {
+  x ^= x >> 32;
+  x ^= x >> 16;
+  x ^= x >> 8;
+  x ^= x >> 4;
+  x ^= x >> 2;
+  x ^= x >> 1;
+  return (int) (x & 1);
+}
+
+
+/**
+ * Berlekamp-Massey over GF(2) on the bit 0 of the first word of the state
+ * after each block transition. Sets minimal and degree.
+ */
+static int berlekamp_massey(void) {
+  const int length = 2 * JUMP_DIMENSION;
+  const int n64 = length / 64 + 4;
+  uint64_t * reversed = (uint64_t *) calloc(n64, sizeof(uint64_t));
+  uint64_t * c = (uint64_t *) calloc(n64, sizeof(uint64_t));
+  uint64_t * b = (uint64_t *) calloc(n64, sizeof(uint64_t));
+  uint64_t * t = (uint64_t *) calloc(n64, sizeof(uint64_t));
+  uint64_t * swap;
+  dsfmt_t dsfmt;
+  int n, i, l = 0, lb = 0, m = 1, j, d, ok = 0;
+
+  if( reversed == NULL || c == NULL || b == NULL || t == NULL )
+    goto done;
+
+  /* reversed bit j is the output bit length - 1 - j */
+  dsfmt_init_gen_rand(&dsfmt, JUMP_SEED);
+  for(n = 0; n < length; ++n) {
+    dsfmt_gen_rand_all(&dsfmt);
+    j = length - 1 - n;
+    reversed[j >> 6] |= (dsfmt.status[0].u[0] & 1) << (j & 63);
+  }
+
+  c[0] = b[0] = 1;
+  for(n = 0; n < length; ++n) {
+    /* discrepancy: sum c[i] * s[n - i], i = 0..l */
+    d = 0;
+    for(i = 0; i <= l / 64; ++i)
+      d ^= parity(c[i] & get_word(reversed, length - 1 - n + 64 * i));
+
+    if( d == 0 ) {
+      ++m;
+    } else if( 2 * l <= n ) {
+      memcpy(t, c, n64 * sizeof(uint64_t));
+      xor_shifted(c, b, lb / 64 + 1, m);
+      swap = b; b = t; t = swap;
+      lb = l;
+      l = n + 1 - l;
+      m = 1;
+    } else {
+      xor_shifted(c, b, lb / 64 + 1, m);
+      ++m;
+    }
+  }
+  /* p(x) = x^l c(1 / x) */
+  degree = l;
+  words = l / 64 + 1;
+  minimal = (uint64_t *) calloc(l / 64 + 2, sizeof(uint64_t));
+  if( minimal == NULL )
+    goto done;
+  for(i = 0; i <= l; ++i) {
+    if( get_bit(c, l - i) )
+      minimal[i >> 6] |= (uint64_t) 1 << (i & 63);
+  }
+  ok = 1;
+
+done:
+  free(reversed);
+  free(c);
+  free(b);
+  free(t);
+  return ok;
+}
+
+
+/**
+ * a = a * x mod p (a has words + 1 words)
+ */
+static void multiply_by_x(uint64_t * a) {
+  int i;
+
+  for(i = words; i > 0; --i)
+    a[i] = (a[i] << 1) | (a[i - 1] >> 63);
+  a[0] <<= 1;
+
+  if( get_bit(a, degree) ) {
+    for(i = 0; i <= degree / 64; ++i)
+      a[i] ^= minimal[i];
+  }
+}
+
+
+/**
+ * Reduces r mod p in place, r has bits up to highest
+ */
+static void reduce(uint64_t * r, int highest) {
+  int hi, lo, i, bits;
+
+  for(hi = highest; hi >= degree; hi = lo - 1) {
+    lo = (hi - 7 > degree) ? hi - 7 : degree;
+    bits = 0;
+    for(i = hi; i >= lo; --i) {
+      bits = (bits << 1) | get_bit(r, i);
+      r[i >> 6] &= ~((uint64_t) 1 << (i & 63));
+    }
+    if( bits != 0 )
+      xor_shifted(r, top + bits * words, words, lo - degree);
+  }
+}
+
+
+/**
+ * Returns x^k mod p in q (words + 1 words), using r (2 * words + 2 words)
+ */
+static void power(uint64_t * q, uint64_t k, uint64_t * r) {
+  int bit, i;
+
+  memset(q, 0, (words + 1) * sizeof(uint64_t));
+  q[0] = 1;
+
+  for(bit = 63; bit >= 0 && !((k >> bit) & 1); --bit)
+    ;
+  for(; bit >= 0; --bit) {
+    /* q = q^2 mod p */
+    memset(r, 0, (2 * words + 2) * sizeof(uint64_t));
+    for(i = 0; i < words; ++i) {
+      r[2 * i] = spread[q[i] & 0xff] | ((uint64_t) spread[(q[i] >> 8) & 0xff] << 16) |
+                 ((uint64_t) spread[(q[i] >> 16) & 0xff] << 32) | ((uint64_t) spread[(q[i] >> 24) & 0xff] << 48);
+      r[2 * i + 1] = spread[(q[i] >> 32) & 0xff] | ((uint64_t) spread[(q[i] >> 40) & 0xff] << 16) |
+                     ((uint64_t) spread[(q[i] >> 48) & 0xff] << 32) | ((uint64_t) spread[q[i] >> 56] << 48);
+    }
+    reduce(r, 2 * degree - 2);
+    memcpy(q, r, words * sizeof(uint64_t));
+    q[words] = 0;
+
+    if( (k >> bit) & 1 )
+      multiply_by_x(q);
+  }
+}
+
+
+/**
+ * Prepares the jump-ahead
+ */
+int dsfmt_jump_prepare(void) {
+  uint64_t * power8;
+  int b, i, t;
+
+  if( top != NULL )
+    return 1;
+
+  for(b = 0; b < 256; ++b) {
+    spread[b] = 0;
+    for(i = 0; i < 8; ++i)
+      spread[b] |= ((b >> i) & 1) << (2 * i);
+  }
+
+  if( minimal == NULL && !berlekamp_massey() )
+    return 0;
+
+  /* power8[t] = x^(degree + t) mod p */
+  power8 = (uint64_t *) calloc(8 * (words + 1), sizeof(uint64_t));
+  top = (uint64_t *) calloc(256 * words + 1, sizeof(uint64_t));
+  if( power8 == NULL || top == NULL ) {
+    free(power8);
+    free(top);
+    top = NULL;
+    return 0;
+  }
+
+  memcpy(power8, minimal, words * sizeof(uint64_t));
+  power8[degree >> 6] &= ~((uint64_t) 1 << (degree & 63));
+  for(t = 1; t < 8; ++t) {
+    memcpy(power8 + t * (words + 1), power8 + (t - 1) * (words + 1), (words + 1) * sizeof(uint64_t));
+    multiply_by_x(power8 + t * (words + 1));
+  }
+
+  for(b = 1; b < 256; ++b) {
+    for(t = 0; t < 8; ++t) {
+      if( (b >> t) & 1 ) {
+        for(i = 0; i < words; ++i)
+          top[b * words + i] ^= power8[t * (words + 1) + i];
+      }
+    }
+  }
+
+  free(power8);
+  return 1;
+}
+
+
+/**
+ * Advances dsfmt by steps values
+ */
+int dsfmt_jump(dsfmt_t * dsfmt, uint64_t steps) {
+  const uint64_t total = (uint64_t) dsfmt->idx + steps;
+  const uint64_t blocks = total / DSFMT_N64;
+  uint64_t * q;
+  uint64_t * r;
+  dsfmt_t * acc;
+  int i, j;
+
+  if( blocks == 0 ) {
+    dsfmt->idx = (int) total;
+    return 1;
+  }
+
+  if( !dsfmt_jump_prepare() )
+    return 0;
+
+  q = (uint64_t *) malloc((words + 1) * sizeof(uint64_t));
+  r = (uint64_t *) malloc((2 * words + 2) * sizeof(uint64_t));
+  acc = (dsfmt_t *) calloc(1, sizeof(dsfmt_t));
+  if( q == NULL || r == NULL || acc == NULL ) {
+    free(q);
+    free(r);
+    free(acc);
+    return 0;
+  }
+
+  power(q, blocks, r);
+
+  /* acc = q(T) s by the Horner scheme */
+  for(i = degree - 1; i >= 0 && !get_bit(q, i); --i)
+    ;
+  for(; i >= 0; --i) {
+    dsfmt_gen_rand_all(acc);
+    if( get_bit(q, i) ) {
+      for(j = 0; j <= DSFMT_N; ++j) {
+        acc->status[j].u[0] ^= dsfmt->status[j].u[0];
+        acc->status[j].u[1] ^= dsfmt->status[j].u[1];
+      }
+    }
+  }
+
+  memcpy(dsfmt->status, acc->status, sizeof(dsfmt->status));
+  dsfmt->idx = (int) (total % DSFMT_N64);
+
+  free(q);
+  free(r);
+  free(acc);
+  return 1;
+}
+
+
+/**
+ * Advances a cRandom object created by dSFMTRandomNew* by steps values
+ */
+int dSFMTRandomJump(struct cRandom * crandom, size_t steps) {
+  return dsfmt_jump((dsfmt_t *) dSFMTRandomState(crandom), (uint64_t) steps);
+}
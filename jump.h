@@ -0,0 +1,58 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __jump_h__
+#define __jump_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+#include "dSFMT/dSFMT.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Prepares the jump-ahead: finds the minimal polynomial of the dSFMT
+ * block transition (Berlekamp-Massey) once per process.
+ *
+ * NOTE: dsfmt_jump calls it on demand, but the first call is not thread
+ *       safe, so call it before jumping from several threads.
+ *
+ * Returns 0 if there is not enough memory, 1 otherwise.
+ */
+int dsfmt_jump_prepare(void);
+
+
+/**
+ * Advances dsfmt as if steps values were taken from it by
+ * dsfmt_genrand_close_open (or any other dsfmt_genrand_* function).
+ *
+ * The cost is O(log(steps)) polynomial squarings plus one pass of
+ * about DSFMT_MEXP block generations, independent of steps.
+ *
+ * Returns 0 if there is not enough memory, 1 otherwise.
+ */
+int dsfmt_jump(dsfmt_t * dsfmt, uint64_t steps);
+
+
+/**
+ * Advance a cRandom object created by dSFMTRandomNew* as if steps values
+ * were taken from it, in time independent of steps (dsfmt_jump).
+ *
+ * Returns 0 if there is not enough memory, 1 otherwise.
+ */
+int dSFMTRandomJump(struct cRandom * crandom, size_t steps);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__jump_h__*/
@@ -0,0 +1,179 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "markov.h"
+
+
+/* Number of chains advanced per bulk fill */
+#define MARKOV_BLOCK (4096)
+
+
+/**
+ * Alias table cell: go to target with probability prob, otherwise to alias
+ */
+struct AliasCell {
+  double prob;
+  int target;
+  int alias;
+};
+
+
+struct MarkovChain {
+  int states;
+
+  int * rowStart;
+  struct AliasCell * cells;
+};
+
+
+/**
+ * Builds the alias table of one row (Vose's method)
+ */
+static void alias_row(struct AliasCell * cells, const int * columns, const double * weights, int n, int * work) {
+  int * small = work;
+  int * large = work + n;
+  double sum = 0.0;
+  int ns = 0, nl = 0, i, s, l;
+
+  for(i = 0; i < n; ++i) {
+    assert( 0.0 <= weights[i] );
+    sum += weights[i];
+  }
+  assert( 0.0 < sum );
+
+  for(i = 0; i < n; ++i) {
+    cells[i].prob = weights[i] * n / sum;
+    cells[i].target = columns[i];
+    cells[i].alias = columns[i];
+    if( cells[i].prob < 1.0 )
+      small[ns++] = i;
+    else
+      large[nl++] = i;
+  }
+
+  while( ns > 0 && nl > 0 ) {
+    s = small[--ns];
+    l = large[nl - 1];
+    cells[s].alias = columns[l];
+    cells[l].prob -= 1.0 - cells[s].prob;
+    if( cells[l].prob < 1.0 ) {
+      --nl;
+      small[ns++] = l;
+    }
+  }
+
+  /* the rest is 1 up to rounding */
+  while( nl > 0 )
+    cells[large[--nl]].prob = 1.0;
+  while( ns > 0 )
+    cells[small[--ns]].prob = 1.0;
+}
+
+
+/**
+ * Create a new Markov chain from a transition matrix in CSR form
+ */
+struct MarkovChain * MarkovChainNew(int states, const int * rowStart, const int * columns, const double * weights) {
+  struct MarkovChain * chain;
+  int * work;
+  int i, widest = 1;
+
+  assert( 0 < states );
+
+  chain = (struct MarkovChain *) malloc(sizeof(*chain));
+  if( chain == NULL )
+    return NULL;
+
+  chain->states = states;
+  chain->rowStart = (int *) malloc((states + 1) * sizeof(int));
+  chain->cells = (struct AliasCell *) malloc(rowStart[states] * sizeof(struct AliasCell));
+  for(i = 0; i < states; ++i) {
+    assert( rowStart[i] < rowStart[i + 1] );
+    if( widest < rowStart[i + 1] - rowStart[i] )
+      widest = rowStart[i + 1] - rowStart[i];
+  }
+  work = (int *) malloc(2 * widest * sizeof(int));
+  if( chain->rowStart == NULL || chain->cells == NULL || work == NULL ) {
+    free(work);
+    MarkovChainRelease(chain);
+    return NULL;
+  }
+
+  memcpy(chain->rowStart, rowStart, (states + 1) * sizeof(int));
+  for(i = 0; i < states; ++i) {
+    alias_row(chain->cells + rowStart[i], columns + rowStart[i], weights + rowStart[i],
+              rowStart[i + 1] - rowStart[i], work);
+  }
+
+  free(work);
+  return chain;
+}
+
+
+/**
+ * Releases resources of a MarkovChain object
+ */
+void MarkovChainRelease(struct MarkovChain * chain) {
+  if( chain == NULL )
+    return;
+
+  free(chain->cells);
+  free(chain->rowStart);
+  free(chain);
+}
+
+
+/**
+ * Returns the next state after state for a uniform u
+ *
+ * One uniform serves both choices: its integer part picks the cell,
+ * its fraction is compared against the cell probability.
+ */
+int MarkovChainNext(const struct MarkovChain * chain, int state, double u) {
+  const int start = chain->rowStart[state];
+  const double v = u * (chain->rowStart[state + 1] - start);
+  const int k = (int) v;
+  const struct AliasCell * cell = &chain->cells[start + k];
+
+  return (v - k < cell->prob) ? cell->target : cell->alias;
+}
+
+
+/**
+ * Advances chains independent chains by steps steps
+ */
+int MarkovChainSimulate(const struct MarkovChain * chain, struct cRandom * crandom,
+                        int * state, size_t chains, int steps, int * trajectory) {
+  double * u;
+  size_t start, n, c;
+  int s;
+
+  u = (double *) malloc(((chains < MARKOV_BLOCK ? chains : MARKOV_BLOCK) + 1) * sizeof(double));
+  if( u == NULL )
+    return 0;
+
+  for(s = 0; s < steps; ++s) {
+    for(start = 0; start < chains; start += n) {
+      n = chains - start;
+      if( n > MARKOV_BLOCK )
+        n = MARKOV_BLOCK;
+
+      random_fill(crandom, u, n);
+      for(c = 0; c < n; ++c)
+        state[start + c] = MarkovChainNext(chain, state[start + c], u[c]);
+
+      if( trajectory != NULL )
+        memcpy(trajectory + s * chains + start, state + start, n * sizeof(int));
+    }
+  }
+
+  free(u);
+  return 1;
+}
@@ -0,0 +1,72 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __markov_h__
+#define __markov_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Discrete-time Markov chain prepared for sampling
+ *
+ * Every row of the transition matrix is turned into an alias table
+ * (Walker, Vose); all tables are packed into one array.
+ */
+struct MarkovChain;
+
+
+/**
+ * Create a new Markov chain from a transition matrix in CSR form:
+ * row i has the transitions to columns[k] with weights weights[k],
+ * rowStart[i] <= k < rowStart[i + 1].
+ *
+ * Weights are normalized per row; every row needs a positive weight.
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct MarkovChain * MarkovChainNew(int states, const int * rowStart, const int * columns, const double * weights);
+
+
+/**
+ * Releases resources of a MarkovChain object
+ */
+void MarkovChainRelease(struct MarkovChain * chain);
+
+
+/**
+ * Returns the next state after state for a uniform u, 0 <= u < 1
+ */
+int MarkovChainNext(const struct MarkovChain * chain, int state, double u);
+
+
+/**
+ * Advances chains independent chains by steps steps.
+ *
+ * state[c] is the current state of the c-th chain (updated in place).
+ * If trajectory is not NULL, the state of the c-th chain after step s
+ * is stored at trajectory[s * chains + c].
+ *
+ * The uniforms for all chains are drawn in one bulk fill per step.
+ *
+ * Returns 0 if there is not enough memory, 1 otherwise.
+ */
+int MarkovChainSimulate(const struct MarkovChain * chain, struct cRandom * crandom,
+                        int * state, size_t chains, int steps, int * trajectory);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__markov_h__*/
@@ -0,0 +1,184 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "metropolis.h"
+
+
+struct Metropolis {
+  int dimension;
+  size_t chains;
+  double * scale;
+
+  MetropolisLogDensity logDensity;
+  void * ctx;
+
+  double * x;          /* states, dimension * chains         */
+  double * lx;         /* log-density at x, chains           */
+  double * y;          /* proposals, dimension * chains      */
+  double * ly;         /* log-density at y, chains           */
+  double * u;          /* acceptance uniforms, chains        */
+  char * accept;       /* acceptance flags, chains           */
+};
+
+
+/**
+ * Create a new sampler
+ */
+struct Metropolis * MetropolisNew(int dimension, size_t chains, const double * scale,
+                                  MetropolisLogDensity logDensity, void * ctx) {
+  struct Metropolis * metropolis;
+  const size_t size = dimension * chains;
+  int d;
+
+  assert( 0 < dimension );
+  assert( 0 < chains );
+
+  metropolis = (struct Metropolis *) calloc(1, sizeof(*metropolis));
+  if( metropolis == NULL )
+    return NULL;
+
+  metropolis->dimension = dimension;
+  metropolis->chains = chains;
+  metropolis->logDensity = logDensity;
+  metropolis->ctx = ctx;
+
+  metropolis->scale = (double *) malloc(dimension * sizeof(double));
+  metropolis->x = (double *) calloc(size, sizeof(double));
+  metropolis->y = (double *) malloc(size * sizeof(double));
+  metropolis->lx = (double *) malloc(chains * sizeof(double));
+  metropolis->ly = (double *) malloc(chains * sizeof(double));
+  metropolis->u = (double *) malloc(chains * sizeof(double));
+  metropolis->accept = (char *) malloc(chains);
+  if( metropolis->scale == NULL || metropolis->x == NULL || metropolis->y == NULL ||
+      metropolis->lx == NULL || metropolis->ly == NULL || metropolis->u == NULL || metropolis->accept == NULL ) {
+    MetropolisRelease(metropolis);
+    return NULL;
+  }
+
+  for(d = 0; d < dimension; ++d) {
+    metropolis->scale[d] = (scale != NULL) ? scale[d] : 1.0;
+    assert( 0.0 < metropolis->scale[d] );
+  }
+
+  metropolis->logDensity(metropolis->ctx, metropolis->x, metropolis->lx, dimension, chains);
+
+  return metropolis;
+}
+
+
+/**
+ * Releases resources of a Metropolis object
+ */
+void MetropolisRelease(struct Metropolis * metropolis) {
+  if( metropolis == NULL )
+    return;
+
+  free(metropolis->scale);
+  free(metropolis->x);
+  free(metropolis->y);
+  free(metropolis->lx);
+  free(metropolis->ly);
+  free(metropolis->u);
+  free(metropolis->accept);
+  free(metropolis);
+}
+
+
+/**
+ * Sets the states of the chains
+ */
+void MetropolisInit(struct Metropolis * metropolis, const double * x) {
+  memcpy(metropolis->x, x, metropolis->dimension * metropolis->chains * sizeof(double));
+  metropolis->logDensity(metropolis->ctx, metropolis->x, metropolis->lx, metropolis->dimension, metropolis->chains);
+}
+
+
+/**
+ * Returns the current states
+ */
+const double * MetropolisState(const struct Metropolis * metropolis) {
+  return metropolis->x;
+}
+
+
+/**
+ * Returns the log-density at the current states
+ */
+const double * MetropolisLogDensityAt(const struct Metropolis * metropolis) {
+  return metropolis->lx;
+}
+
+
+/**
+ * Makes one step of every chain, returns the number of accepted proposals
+ */
+static size_t step(struct Metropolis * metropolis, struct cRandom * crandom) {
+  const size_t chains = metropolis->chains;
+  double * const x = metropolis->x;
+  double * const y = metropolis->y;
+  double * const lx = metropolis->lx;
+  const double * const ly = metropolis->ly;
+  const double * const u = metropolis->u;
+  char * const accept = metropolis->accept;
+  size_t c, accepted = 0;
+  int d;
+
+  normal_fill(crandom, 0.0, 1.0, y, metropolis->dimension * chains);
+  random_fill(crandom, metropolis->u, chains);
+
+  for(d = 0; d < metropolis->dimension; ++d) {
+    const double s = metropolis->scale[d];
+    double * const yd = y + d * chains;
+    const double * const xd = x + d * chains;
+
+    for(c = 0; c < chains; ++c)
+      yd[c] = xd[c] + s * yd[c];
+  }
+
+  metropolis->logDensity(metropolis->ctx, y, metropolis->ly, metropolis->dimension, chains);
+
+  /* accept with probability min(1, exp(ly - lx)); log(0) = -inf accepts */
+  for(c = 0; c < chains; ++c) {
+    accept[c] = (char) (log(u[c]) < ly[c] - lx[c]);
+    accepted += accept[c];
+  }
+
+  /* selections only, so that the loops vectorize */
+  for(c = 0; c < chains; ++c)
+    lx[c] = accept[c] ? ly[c] : lx[c];
+  for(d = 0; d < metropolis->dimension; ++d) {
+    double * const xd = x + d * chains;
+    const double * const yd = y + d * chains;
+
+    for(c = 0; c < chains; ++c)
+      xd[c] = accept[c] ? yd[c] : xd[c];
+  }
+
+  return accepted;
+}
+
+
+/**
+ * Advances every chain by steps steps
+ */
+size_t MetropolisRun(struct Metropolis * metropolis, struct cRandom * crandom, int steps, double * trace) {
+  const size_t size = metropolis->dimension * metropolis->chains;
+  size_t accepted = 0;
+  int s;
+
+  for(s = 0; s < steps; ++s) {
+    accepted += step(metropolis, crandom);
+    if( trace != NULL )
+      memcpy(trace + s * size, metropolis->x, size * sizeof(double));
+  }
+
+  return accepted;
+}
@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __metropolis_h__
+#define __metropolis_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Vectorized log-density: for every chain c, 0 <= c < chains, stores in
+ * logDensity[c] the log of the (unnormalized) target density at the point
+ * with coordinates x[d * chains + c], 0 <= d < dimension.
+ *
+ * Return -HUGE_VAL outside of the support.
+ */
+typedef void (* MetropolisLogDensity)(void * ctx, const double * x, double * logDensity, int dimension, size_t chains);
+
+
+/**
+ * Random-walk Metropolis sampler running many independent chains in
+ * lockstep, with the states in structure of arrays form.
+ */
+struct Metropolis;
+
+
+/**
+ * Create a new sampler of chains chains in dimension dimension.
+ *
+ * The proposal is x + scale[d] * z with standard normal z; scale may be
+ * NULL (every scale is 1.0).
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct Metropolis * MetropolisNew(int dimension, size_t chains, const double * scale,
+                                  MetropolisLogDensity logDensity, void * ctx);
+
+
+/**
+ * Releases resources of a Metropolis object
+ */
+void MetropolisRelease(struct Metropolis * metropolis);
+
+
+/**
+ * Sets the states of the chains (x[d * chains + c]) and evaluates the
+ * log-density there.
+ */
+void MetropolisInit(struct Metropolis * metropolis, const double * x);
+
+
+/**
+ * Returns the current states, x[d * chains + c]
+ */
+const double * MetropolisState(const struct Metropolis * metropolis);
+
+
+/**
+ * Returns the log-density at the current states, one per chain
+ */
+const double * MetropolisLogDensityAt(const struct Metropolis * metropolis);
+
+
+/**
+ * Advances every chain by steps steps.
+ *
+ * Every step takes dimension * chains normals (normal_fill) for the
+ * proposals and then chains uniforms (random_fill) for the acceptance
+ * tests, and calls the log-density once on the whole batch of proposals.
+ *
+ * If trace is not NULL, the states after step s are stored at
+ * trace + s * dimension * chains.
+ *
+ * Returns the number of accepted proposals.
+ */
+size_t MetropolisRun(struct Metropolis * metropolis, struct cRandom * crandom, int steps, double * trace);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__metropolis_h__*/
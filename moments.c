@@ -0,0 +1,220 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <math.h>
+
+#include "moments.h"
+
+
+/* Number of values of one block */
+#define MOMENTS_BLOCK (1024)
+
+/* Number of independent lanes of the block sums */
+#define MOMENTS_LANES (4)
+
+
+/**
+ * Initializes an empty accumulator
+ */
+void moments_init(struct Moments * moments, int compensated) {
+  moments->n = 0.0;
+  moments->mean = 0.0;
+  moments->m2 = 0.0;
+  moments->m3 = 0.0;
+  moments->m4 = 0.0;
+
+  moments->compensated = compensated;
+  moments->c1 = 0.0;
+  moments->c2 = 0.0;
+  moments->c3 = 0.0;
+  moments->c4 = 0.0;
+}
+
+
+/**
+ * sum += x with the Kahan compensation c
+ */
+static void kahan(double * sum, double * c, double x) {
+  const double y = x - *c;
+  const double t = *sum + y;
+
+  *c = (t - *sum) - y;
+  *sum = t;
+}
+
+
+/**
+ * Adds the values of source to moments
+ */
+void moments_merge(struct Moments * moments, const struct Moments * source) {
+  const double na = moments->n;
+  const double nb = source->n;
+  const double n = na + nb;
+  double d, d2, m2, m3, m4;
+
+  if( nb == 0.0 )
+    return;
+  if( na == 0.0 ) {
+    moments->n = source->n;
+    moments->mean = source->mean;
+    moments->m2 = source->m2;
+    moments->m3 = source->m3;
+    moments->m4 = source->m4;
+    moments->c1 = source->c1;
+    moments->c2 = source->c2;
+    moments->c3 = source->c3;
+    moments->c4 = source->c4;
+    return;
+  }
+
+  d = (source->mean - source->c1) - (moments->mean - moments->c1);
+  d2 = d * d;
+
+  m2 = source->m2 + d2 * na * nb / n;
+  m3 = source->m3 + d * d2 * na * nb * (na - nb) / (n * n)
+     + 3.0 * d * (na * source->m2 - nb * moments->m2) / n;
+  m4 = source->m4 + d2 * d2 * na * nb * (na * na - na * nb + nb * nb) / (n * n * n)
+     + 6.0 * d2 * (na * na * source->m2 + nb * nb * moments->m2) / (n * n)
+     + 4.0 * d * (na * source->m3 - nb * moments->m3) / n;
+
+  if( moments->compensated ) {
+    kahan(&moments->m4, &moments->c4, m4 - source->c4);
+    kahan(&moments->m3, &moments->c3, m3 - source->c3);
+    kahan(&moments->m2, &moments->c2, m2 - source->c2);
+    kahan(&moments->mean, &moments->c1, d * nb / n);
+  } else {
+    moments->m4 += m4;
+    moments->m3 += m3;
+    moments->m2 += m2;
+    moments->mean += d * nb / n;
+  }
+  moments->n = n;
+}
+
+
+/**
+ * Adds one value
+ */
+void moments_add(struct Moments * moments, double x) {
+  struct Moments one;
+
+  moments_init(&one, 0);
+  one.n = 1.0;
+  one.mean = x;
+  moments_merge(moments, &one);
+}
+
+
+/**
+ * Returns the moments of one block
+ */
+static void block_moments(struct Moments * block, const double * x, int size, int compensated) {
+  double s[MOMENTS_LANES], c[MOMENTS_LANES];
+  double s2[MOMENTS_LANES], s3[MOMENTS_LANES], s4[MOMENTS_LANES];
+  double mean, d, d2;
+  int i, j;
+
+  for(j = 0; j < MOMENTS_LANES; ++j)
+    s[j] = c[j] = s2[j] = s3[j] = s4[j] = 0.0;
+
+  /* first pass: mean */
+  if( compensated ) {
+    for(i = 0; i + MOMENTS_LANES <= size; i += MOMENTS_LANES) {
+      for(j = 0; j < MOMENTS_LANES; ++j) {
+        const double y = x[i + j] - c[j];
+        const double t = s[j] + y;
+
+        c[j] = (t - s[j]) - y;
+        s[j] = t;
+      }
+    }
+  } else {
+    for(i = 0; i + MOMENTS_LANES <= size; i += MOMENTS_LANES) {
+      for(j = 0; j < MOMENTS_LANES; ++j)
+        s[j] += x[i + j];
+    }
+  }
+  for(; i < size; ++i)
+    s[0] += x[i];
+  mean = ((s[0] + s[1]) + (s[2] + s[3]) - ((c[0] + c[1]) + (c[2] + c[3]))) / size;
+
+  /* second pass: central sums, the block is still in the cache */
+  for(i = 0; i + MOMENTS_LANES <= size; i += MOMENTS_LANES) {
+    for(j = 0; j < MOMENTS_LANES; ++j) {
+      d = x[i + j] - mean;
+      d2 = d * d;
+      s2[j] += d2;
+      s3[j] += d2 * d;
+      s4[j] += d2 * d2;
+    }
+  }
+  for(; i < size; ++i) {
+    d = x[i] - mean;
+    d2 = d * d;
+    s2[0] += d2;
+    s3[0] += d2 * d;
+    s4[0] += d2 * d2;
+  }
+
+  moments_init(block, 0);
+  block->n = size;
+  block->mean = mean;
+  block->m2 = (s2[0] + s2[1]) + (s2[2] + s2[3]);
+  block->m3 = (s3[0] + s3[1]) + (s3[2] + s3[3]);
+  block->m4 = (s4[0] + s4[1]) + (s4[2] + s4[3]);
+}
+
+
+/**
+ * Adds size values
+ */
+void moments_add_array(struct Moments * moments, const double * array, size_t size) {
+  struct Moments block;
+  size_t offset;
+  int n;
+
+  for(offset = 0; offset < size; offset += n) {
+    n = (size - offset < MOMENTS_BLOCK) ? (int) (size - offset) : MOMENTS_BLOCK;
+    block_moments(&block, array + offset, n, moments->compensated);
+    moments_merge(moments, &block);
+  }
+}
+
+
+/**
+ * Returns the mean
+ */
+double moments_mean(const struct Moments * moments) {
+  return moments->mean - moments->c1;
+}
+
+
+/**
+ * Returns the unbiased variance
+ */
+double moments_variance(const struct Moments * moments) {
+  return (moments->m2 - moments->c2) / (moments->n - 1.0);
+}
+
+
+/**
+ * Returns the skewness
+ */
+double moments_skewness(const struct Moments * moments) {
+  const double m2 = moments->m2 - moments->c2;
+
+  return sqrt(moments->n) * (moments->m3 - moments->c3) / (m2 * sqrt(m2));
+}
+
+
+/**
+ * Returns the excess kurtosis
+ */
+double moments_kurtosis(const struct Moments * moments) {
+  const double m2 = moments->m2 - moments->c2;
+
+  return moments->n * (moments->m4 - moments->c4) / (m2 * m2) - 3.0;
+}
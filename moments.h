@@ -0,0 +1,98 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __moments_h__
+#define __moments_h__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Streaming accumulator of the first four moments
+ *
+ * It keeps the count, the mean and the central sums m2, m3, m4 (Welford);
+ * two accumulators are combined by the formulas of Chan, Golub and
+ * LeVeque, so partial results of threads or blocks merge without loss.
+ */
+struct Moments {
+  double n;
+  double mean;
+  double m2;
+  double m3;
+  double m4;
+
+  /* Kahan-compensated mode: compensation of the running sums */
+  int compensated;
+  double c1;
+  double c2;
+  double c3;
+  double c4;
+};
+
+
+/**
+ * Initializes an empty accumulator; compensated != 0 turns on the
+ * Kahan-compensated summation (slower, for very long streams).
+ */
+void moments_init(struct Moments * moments, int compensated);
+
+
+/**
+ * Adds one value
+ */
+void moments_add(struct Moments * moments, double x);
+
+
+/**
+ * Adds size values, e.g. the output of one of the *_fill functions.
+ *
+ * Values are processed in blocks: the block moments are computed by two
+ * passes with several independent lanes (so that the loops vectorize)
+ * and merged into the accumulator.
+ */
+void moments_add_array(struct Moments * moments, const double * array, size_t size);
+
+
+/**
+ * Adds the values of source to moments
+ */
+void moments_merge(struct Moments * moments, const struct Moments * source);
+
+
+/**
+ * Returns the mean
+ */
+double moments_mean(const struct Moments * moments);
+
+
+/**
+ * Returns the unbiased variance, m2 / (n - 1)
+ */
+double moments_variance(const struct Moments * moments);
+
+
+/**
+ * Returns the skewness, sqrt(n) m3 / m2^(3/2)
+ */
+double moments_skewness(const struct Moments * moments);
+
+
+/**
+ * Returns the excess kurtosis, n m4 / m2^2 - 3
+ */
+double moments_kurtosis(const struct Moments * moments);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__moments_h__*/
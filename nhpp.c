@@ -0,0 +1,269 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "counters.h"
+#include "nhpp.h"
+#include "probes.h"
+
+
+/* Number of variates drawn per batch */
+#define NHPP_BATCH (512)
+
+/* Limits of the adaptation of the piece width (relative to the initial one) */
+#define NHPP_MIN_PIECE (1.0 / 1024)
+#define NHPP_MAX_PIECE (64.0)
+
+
+struct Nhpp {
+  int thinning;
+
+  /* piecewise: segment i is [t[i], t[i + 1]) with rate r[i] + slope[i] * (x - t[i]) */
+  int knots;
+  double * t;
+  double * r;
+  double * slope;
+  double * cumulative;     /* integral of the rate over [t[0], t[i]) */
+  int segment;
+  double target;           /* integral of the rate up to the next event */
+
+  /* thinning */
+  double (* rate)(void * ctx, double t);
+  double (* bound)(void * ctx, double a, double b);
+  void * ctx;
+  double now;
+  double end;
+  double piece;            /* initial piece width */
+  double width;            /* current piece width */
+  double pieceEnd;
+  double pieceBound;
+  size_t proposed;
+  size_t accepted;
+
+  /* batched variates */
+  double exponentials[NHPP_BATCH];
+  double uniforms[NHPP_BATCH];
+  int used;
+};
+
+
+/**
+ * Create a new generator for a piecewise rate function
+ */
+struct Nhpp * NhppNewPiecewise(int knots, const double * times, const double * rates, int linear) {
+  struct Nhpp * nhpp;
+  double dt;
+  int i;
+
+  assert( 1 < knots );
+
+  nhpp = (struct Nhpp *) calloc(1, sizeof(*nhpp));
+  if( nhpp == NULL )
+    return NULL;
+
+  nhpp->knots = knots;
+  nhpp->t = (double *) malloc(knots * sizeof(double));
+  nhpp->r = (double *) malloc(knots * sizeof(double));
+  nhpp->slope = (double *) malloc(knots * sizeof(double));
+  nhpp->cumulative = (double *) malloc(knots * sizeof(double));
+  if( nhpp->t == NULL || nhpp->r == NULL || nhpp->slope == NULL || nhpp->cumulative == NULL ) {
+    NhppRelease(nhpp);
+    return NULL;
+  }
+
+  memcpy(nhpp->t, times, knots * sizeof(double));
+  memcpy(nhpp->r, rates, knots * sizeof(double));
+
+  nhpp->cumulative[0] = 0.0;
+  for(i = 0; i + 1 < knots; ++i) {
+    assert( times[i] < times[i + 1] );
+    assert( 0.0 <= rates[i] && 0.0 <= rates[i + 1] );
+
+    dt = times[i + 1] - times[i];
+    nhpp->slope[i] = linear ? (rates[i + 1] - rates[i]) / dt : 0.0;
+    nhpp->cumulative[i + 1] = nhpp->cumulative[i] + rates[i] * dt + 0.5 * nhpp->slope[i] * dt * dt;
+  }
+  nhpp->slope[knots - 1] = 0.0;
+
+  nhpp->used = NHPP_BATCH;
+  return nhpp;
+}
+
+
+/**
+ * Create a new generator for an arbitrary rate function
+ */
+struct Nhpp * NhppNewThinning(double (* rate)(void * ctx, double t),
+                              double (* bound)(void * ctx, double a, double b), void * ctx,
+                              double start, double end, double piece) {
+  struct Nhpp * nhpp;
+
+  assert( start < end && 0.0 < piece );
+
+  nhpp = (struct Nhpp *) calloc(1, sizeof(*nhpp));
+  if( nhpp == NULL )
+    return NULL;
+
+  nhpp->thinning = 1;
+  nhpp->rate = rate;
+  nhpp->bound = bound;
+  nhpp->ctx = ctx;
+  nhpp->now = start;
+  nhpp->end = end;
+  nhpp->piece = piece;
+  nhpp->width = piece;
+  nhpp->pieceEnd = start;
+  nhpp->pieceBound = 0.0;
+
+  nhpp->used = NHPP_BATCH;
+  return nhpp;
+}
+
+
+/**
+ * Releases resources of a Nhpp object
+ */
+void NhppRelease(struct Nhpp * nhpp) {
+  if( nhpp == NULL )
+    return;
+
+  free(nhpp->cumulative);
+  free(nhpp->slope);
+  free(nhpp->r);
+  free(nhpp->t);
+  free(nhpp);
+}
+
+
+/**
+ * Refills the batches of exponential(1) and uniform variates
+ */
+static void refill(struct Nhpp * nhpp, struct cRandom * crandom) {
+  exponential_fill(crandom, 1.0, nhpp->exponentials, NHPP_BATCH);
+  if( nhpp->thinning )
+    random_fill(crandom, nhpp->uniforms, NHPP_BATCH);
+  nhpp->used = 0;
+}
+
+
+/**
+ * Inversion: the event times are the points where the cumulative rate
+ * reaches the arrival times of a unit-rate Poisson process
+ */
+static size_t fill_piecewise(struct Nhpp * nhpp, struct cRandom * crandom, double * times, size_t capacity) {
+  const int last = nhpp->knots - 1;
+  size_t count = 0;
+  double d, r, s, q;
+  int i = nhpp->segment;
+
+  while( count < capacity ) {
+    if( nhpp->used == NHPP_BATCH )
+      refill(nhpp, crandom);
+    nhpp->target += nhpp->exponentials[nhpp->used++];
+
+    while( i < last && nhpp->cumulative[i + 1] <= nhpp->target )
+      ++i;
+    if( i == last )
+      break;
+
+    /* solve r * x + s * x^2 / 2 = d for x in the segment */
+    d = nhpp->target - nhpp->cumulative[i];
+    r = nhpp->r[i];
+    s = nhpp->slope[i];
+    if( s == 0.0 )
+      times[count++] = nhpp->t[i] + d / r;
+    else {
+      q = r * r + 2.0 * s * d;
+      times[count++] = nhpp->t[i] + 2.0 * d / (r + sqrt(q > 0.0 ? q : 0.0));
+    }
+  }
+
+  nhpp->segment = i;
+  return count;
+}
+
+
+/**
+ * Starts the next piece of the thinning majorant, adapting its width
+ */
+static void next_piece(struct Nhpp * nhpp) {
+  if( nhpp->proposed >= 16 ) {
+    if( 2 * nhpp->accepted < nhpp->proposed && nhpp->width > NHPP_MIN_PIECE * nhpp->piece )
+      nhpp->width *= 0.5;
+    else if( 10 * nhpp->accepted > 9 * nhpp->proposed && nhpp->width < NHPP_MAX_PIECE * nhpp->piece )
+      nhpp->width *= 2.0;
+  }
+  nhpp->proposed = 0;
+  nhpp->accepted = 0;
+
+  nhpp->now = nhpp->pieceEnd;
+  nhpp->pieceEnd = nhpp->now + nhpp->width;
+  if( nhpp->pieceEnd > nhpp->end )
+    nhpp->pieceEnd = nhpp->end;
+  nhpp->pieceBound = nhpp->bound(nhpp->ctx, nhpp->now, nhpp->pieceEnd);
+}
+
+
+/**
+ * Lewis-Shedler thinning against a piecewise constant majorant.
+ * A proposal beyond the end of a piece is discarded and the process is
+ * restarted at the boundary, which is exact by the memorylessness.
+ */
+static size_t fill_thinning(struct Nhpp * nhpp, struct cRandom * crandom, double * times, size_t capacity) {
+  size_t count = 0, rejected = 0;
+  double t;
+
+  while( count < capacity ) {
+    if( nhpp->now >= nhpp->pieceEnd || !(nhpp->pieceBound > 0.0) ) {
+      if( nhpp->pieceEnd >= nhpp->end )
+        break;
+      next_piece(nhpp);
+      continue;
+    }
+
+    if( nhpp->used == NHPP_BATCH )
+      refill(nhpp, crandom);
+
+    t = nhpp->now + nhpp->exponentials[nhpp->used] / nhpp->pieceBound;
+    if( t >= nhpp->pieceEnd ) {
+      nhpp->now = nhpp->pieceEnd;
+      nhpp->used++;
+      continue;
+    }
+
+    nhpp->now = t;
+    nhpp->proposed++;
+    assert( nhpp->rate(nhpp->ctx, t) <= nhpp->pieceBound );
+    if( nhpp->uniforms[nhpp->used] * nhpp->pieceBound < nhpp->rate(nhpp->ctx, t) ) {
+      nhpp->accepted++;
+      times[count++] = t;
+      if( CRANDOM_PROBE_ENABLED(nhpp_loop) && rejected > CRANDOM_PROBE_LOOP )
+        CRANDOM_PROBE2(nhpp_loop, rejected, CRANDOM_PROBE_MICRO(t));
+      rejected = 0;
+    } else {
+      CRANDOM_COUNT(CRANDOM_NHPP_REJECTIONS, 1);
+      ++rejected;
+    }
+    nhpp->used++;
+  }
+
+  return count;
+}
+
+
+/**
+ * Writes the next event times in increasing order into times
+ */
+size_t NhppFill(struct Nhpp * nhpp, struct cRandom * crandom, double * times, size_t capacity) {
+  if( nhpp->thinning )
+    return fill_thinning(nhpp, crandom, times, capacity);
+
+  return fill_piecewise(nhpp, crandom, times, capacity);
+}
@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __nhpp_h__
+#define __nhpp_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Generator of the event times of a non-homogeneous Poisson process
+ */
+struct Nhpp;
+
+
+/**
+ * Create a new generator for a piecewise rate function given at
+ * knots times[0] < ... < times[knots - 1]:
+ *
+ *   linear == 0: rate rates[i] on [times[i], times[i + 1])
+ *   linear != 0: rate interpolated linearly between rates[i] and rates[i + 1]
+ *
+ * Events are produced by inversion of the cumulative rate.
+ * NOTE: use knots > 1 and rates[i] >= 0.0
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct Nhpp * NhppNewPiecewise(int knots, const double * times, const double * rates, int linear);
+
+
+/**
+ * Create a new generator for an arbitrary rate function on [start, end)
+ * by Lewis-Shedler thinning.
+ *
+ * bound(ctx, a, b) must return an upper bound of rate(ctx, t) on [a, b).
+ * The interval is covered by pieces with own bounds; the width of the
+ * pieces starts at piece and adapts to the acceptance rate.
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct Nhpp * NhppNewThinning(double (* rate)(void * ctx, double t),
+                              double (* bound)(void * ctx, double a, double b), void * ctx,
+                              double start, double end, double piece);
+
+
+/**
+ * Releases resources of a Nhpp object
+ */
+void NhppRelease(struct Nhpp * nhpp);
+
+
+/**
+ * Writes the next event times in increasing order into times.
+ *
+ * Returns the number of events written; it is less than capacity only
+ * when the end of the rate function is reached.
+ *
+ * NOTE: random variates are drawn from crandom in batches ahead of use,
+ *       so use the same crandom for all calls of one generator.
+ */
+size_t NhppFill(struct Nhpp * nhpp, struct cRandom * crandom, double * times, size_t capacity);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__nhpp_h__*/
@@ -0,0 +1,639 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "jump.h"
+#include "parallel.h"
+
+
+/* Size of a cache line, to keep workers apart */
+#define CACHE_LINE (64)
+
+/* Smallest chunk of crandom_parallel_fill worth a jump */
+#define FILL_CHUNK (1 << 20)
+
+/* Number of variates of one task with private accumulators */
+#define PRIVATE_TASK (1 << 20)
+
+/* Buffer of a private accumulator */
+#define PRIVATE_BUFFER (4096)
+
+/* Number of variates of one crandom_parallel_moments task */
+#define MOMENTS_TASK (1 << 20)
+
+/* Buffer of a crandom_parallel_moments task */
+#define MOMENTS_BUFFER (4096)
+
+/* Buffer of a crandom_sequential_mc batch */
+#define SEQUENTIAL_BUFFER (4096)
+
+
+/**
+ * Worker of the pool; it owns the task range [begin, end), pops tasks
+ * from the front, and thieves take the upper half of the range.
+ */
+struct Worker {
+  pthread_mutex_t lock;
+  size_t begin;
+  size_t end;
+
+  pthread_t thread;
+  struct Pool * pool;
+  int index;
+  int failed;
+
+  char padding[CACHE_LINE];
+};
+
+
+struct Pool {
+  struct Worker * workers;
+  int threads;
+
+  cRandomTask fn;
+  void * ctx;
+  int seed;
+
+  /* task t uses the stream of task first + t */
+  size_t first;
+};
+
+
+/**
+ * Returns the number of online processors
+ */
+int crandom_thread_count(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return n > 0 ? (int) n : 1;
+}
+
+
+static int pop(struct Worker * worker, size_t * task) {
+  int found = 0;
+
+  pthread_mutex_lock(&worker->lock);
+  if( worker->begin < worker->end ) {
+    *task = worker->begin++;
+    found = 1;
+  }
+  pthread_mutex_unlock(&worker->lock);
+
+  return found;
+}
+
+
+/**
+ * Moves the upper half of the range of some other worker to self.
+ * Returns 0 when there is nothing left to steal.
+ */
+static int steal(struct Worker * self) {
+  struct Pool * pool = self->pool;
+  struct Worker * victim;
+  size_t begin = 0, end = 0;
+  int i;
+
+  for(i = 1; i < pool->threads; ++i) {
+    victim = &pool->workers[(self->index + i) % pool->threads];
+
+    pthread_mutex_lock(&victim->lock);
+    if( victim->begin < victim->end ) {
+      begin = victim->begin + (victim->end - victim->begin) / 2;
+      end = victim->end;
+      victim->end = begin;
+    }
+    pthread_mutex_unlock(&victim->lock);
+
+    if( begin < end ) {
+      pthread_mutex_lock(&self->lock);
+      self->begin = begin;
+      self->end = end;
+      pthread_mutex_unlock(&self->lock);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+/**
+ * Initializes crandom by the key (seed, task)
+ */
+static void task_stream(struct cRandom * crandom, int seed, size_t task) {
+  int key[3];
+
+  key[0] = seed;
+  key[1] = (int) (task & 0xffffffffUL);
+  key[2] = (int) ((task >> 16) >> 16);
+  dSFMTRandomInitByArray(crandom, key, 3);
+}
+
+
+static void * work(void * argument) {
+  struct Worker * self = (struct Worker *) argument;
+  struct Pool * pool = self->pool;
+  struct cRandom * crandom = dSFMTRandomNewBySeed(pool->seed);
+  size_t task;
+
+  if( crandom == NULL ) {
+    self->failed = 1;
+    return NULL;
+  }
+
+  for(;;) {
+    if( !pop(self, &task) ) {
+      if( !steal(self) )
+        break;
+      continue;
+    }
+
+    task_stream(crandom, pool->seed, pool->first + task);
+    pool->fn(pool->ctx, task, crandom);
+  }
+
+  crandom->release(crandom);
+  return NULL;
+}
+
+
+/**
+ * Runs tasks with work stealing, task t with the stream of task first + t
+ */
+static int run_tasks(size_t first, size_t tasks, cRandomTask fn, void * ctx, int seed, int threads) {
+  struct Pool pool;
+  size_t rem;
+  int i, started, ok = 1;
+
+  if( threads <= 0 )
+    threads = crandom_thread_count();
+  if( (size_t) threads > tasks )
+    threads = tasks > 0 ? (int) tasks : 1;
+
+  pool.threads = threads;
+  pool.fn = fn;
+  pool.ctx = ctx;
+  pool.seed = seed;
+  pool.first = first;
+  pool.workers = (struct Worker *) calloc(threads, sizeof(struct Worker));
+  if( pool.workers == NULL )
+    return 0;
+
+  rem = tasks % threads;
+  for(i = 0; i < threads; ++i) {
+    pthread_mutex_init(&pool.workers[i].lock, NULL);
+    pool.workers[i].begin = tasks / threads * i + ((size_t) i < rem ? (size_t) i : rem);
+    pool.workers[i].end = pool.workers[i].begin + tasks / threads + ((size_t) i < rem ? 1 : 0);
+    pool.workers[i].pool = &pool;
+    pool.workers[i].index = i;
+  }
+
+  /* worker 0 runs in the calling thread */
+  for(started = 1; started < threads; ++started) {
+    if( pthread_create(&pool.workers[started].thread, NULL, &work, &pool.workers[started]) != 0 )
+      break;
+  }
+  work(&pool.workers[0]);
+
+  for(i = 1; i < started; ++i)
+    pthread_join(pool.workers[i].thread, NULL);
+  for(i = 0; i < threads; ++i) {
+    if( pool.workers[i].failed )
+      ok = 0;
+    pthread_mutex_destroy(&pool.workers[i].lock);
+  }
+  /* workers which did not start leave no work behind: it is stolen */
+
+  free(pool.workers);
+  return ok;
+}
+
+
+/**
+ * Runs tasks with work stealing
+ */
+int crandom_parallel_mc(size_t tasks, cRandomTask fn, void * ctx, int seed, int threads) {
+  return run_tasks(0, tasks, fn, ctx, seed, threads);
+}
+
+
+/**
+ * Chunk of crandom_parallel_fill
+ */
+struct FillChunk {
+  struct cRandom * crandom;
+  double * array;
+  size_t offset;
+  size_t size;
+
+  pthread_t thread;
+  int failed;
+};
+
+
+static void * fill(void * argument) {
+  struct FillChunk * chunk = (struct FillChunk *) argument;
+
+  if( !dSFMTRandomJump(chunk->crandom, chunk->offset) ) {
+    chunk->failed = 1;
+    return NULL;
+  }
+  random_fill(chunk->crandom, chunk->array + chunk->offset, chunk->size);
+
+  return NULL;
+}
+
+
+/**
+ * Parallel random_fill
+ */
+int crandom_parallel_fill(struct cRandom * crandom, double * array, size_t size, int threads) {
+  struct FillChunk * chunks;
+  int i, started, ok = 1;
+
+  if( threads <= 0 )
+    threads = crandom_thread_count();
+  if( (size_t) threads > size / FILL_CHUNK )
+    threads = size / FILL_CHUNK > 0 ? (int) (size / FILL_CHUNK) : 1;
+
+  if( threads == 1 ) {
+    random_fill(crandom, array, size);
+    return 1;
+  }
+
+  /* the first use of the jump is not thread safe */
+  if( !dsfmt_jump_prepare() )
+    return 0;
+
+  chunks = (struct FillChunk *) calloc(threads, sizeof(struct FillChunk));
+  if( chunks == NULL )
+    return 0;
+
+  /* the last chunk goes to crandom itself, so it ends after array */
+  for(i = 0; i < threads; ++i) {
+    chunks[i].array = array;
+    chunks[i].offset = size / threads * i;
+    chunks[i].size = (i + 1 < threads) ? size / threads : size - chunks[i].offset;
+    chunks[i].crandom = (i + 1 < threads) ? dSFMTRandomClone(crandom) : crandom;
+    if( chunks[i].crandom == NULL )
+      ok = 0;
+  }
+
+  if( ok ) {
+    for(started = 0; started + 1 < threads; ++started) {
+      if( pthread_create(&chunks[started].thread, NULL, &fill, &chunks[started]) != 0 )
+        break;
+    }
+    /* chunks which did not start run in the calling thread */
+    for(i = started; i < threads; ++i)
+      fill(&chunks[i]);
+    for(i = 0; i < started; ++i)
+      pthread_join(chunks[i].thread, NULL);
+
+    for(i = 0; i < threads; ++i) {
+      if( chunks[i].failed )
+        ok = 0;
+    }
+  }
+
+  for(i = 0; i + 1 < threads; ++i) {
+    if( chunks[i].crandom != NULL )
+      chunks[i].crandom->release(chunks[i].crandom);
+  }
+  free(chunks);
+  return ok;
+}
+
+
+/**
+ * Private accumulator of a thread (a histogram or a sketch) with its
+ * sample buffer
+ */
+struct PrivateSlot {
+  void * accumulator;
+  double * buffer;
+};
+
+
+/**
+ * Sampling into private accumulators, merged into target at the end
+ */
+struct PrivateJob {
+  size_t samples;
+  cRandomSampler sampler;
+  void * ctx;
+
+  void * target;
+  void * (* create)(const void * target);
+  void (* add)(void * accumulator, const double * array, size_t size);
+  void (* merge)(void * target, const void * accumulator);
+  void (* release)(void * accumulator);
+
+  /* stack of free slots; at most one slot per running task */
+  pthread_mutex_t lock;
+  struct PrivateSlot * slots;
+  int * free;
+  int available;
+};
+
+
+static void private_task(void * ctx, size_t task, struct cRandom * crandom) {
+  struct PrivateJob * job = (struct PrivateJob *) ctx;
+  struct PrivateSlot * slot;
+  size_t offset = task * PRIVATE_TASK, end, block;
+  int index;
+
+  end = (job->samples - offset < PRIVATE_TASK) ? job->samples : offset + PRIVATE_TASK;
+
+  pthread_mutex_lock(&job->lock);
+  assert( job->available > 0 );
+  index = job->free[--job->available];
+  pthread_mutex_unlock(&job->lock);
+
+  slot = &job->slots[index];
+  for(; offset < end; offset += block) {
+    block = (end - offset < PRIVATE_BUFFER) ? end - offset : PRIVATE_BUFFER;
+    job->sampler(job->ctx, crandom, slot->buffer, block);
+    job->add(slot->accumulator, slot->buffer, block);
+  }
+
+  pthread_mutex_lock(&job->lock);
+  job->free[job->available++] = index;
+  pthread_mutex_unlock(&job->lock);
+}
+
+
+/**
+ * Runs a PrivateJob on threads threads
+ */
+static int private_run(struct PrivateJob * job, int seed, int threads) {
+  const size_t tasks = (job->samples + PRIVATE_TASK - 1) / PRIVATE_TASK;
+  int i, ok = 0;
+
+  if( threads <= 0 )
+    threads = crandom_thread_count();
+  if( (size_t) threads > tasks )
+    threads = tasks > 0 ? (int) tasks : 1;
+
+  job->slots = (struct PrivateSlot *) calloc(threads, sizeof(struct PrivateSlot));
+  job->free = (int *) malloc(threads * sizeof(int));
+  job->available = threads;
+  pthread_mutex_init(&job->lock, NULL);
+  if( job->slots == NULL || job->free == NULL )
+    goto failure;
+
+  for(i = 0; i < threads; ++i) {
+    job->slots[i].accumulator = job->create(job->target);
+    job->slots[i].buffer = (double *) malloc(PRIVATE_BUFFER * sizeof(double));
+    if( job->slots[i].accumulator == NULL || job->slots[i].buffer == NULL )
+      goto failure;
+    job->free[i] = i;
+  }
+
+  if( !crandom_parallel_mc(tasks, &private_task, job, seed, threads) )
+    goto failure;
+
+  for(i = 0; i < threads; ++i)
+    job->merge(job->target, job->slots[i].accumulator);
+  ok = 1;
+
+failure:
+  if( job->slots != NULL ) {
+    for(i = 0; i < threads; ++i) {
+      if( job->slots[i].accumulator != NULL )
+        job->release(job->slots[i].accumulator);
+      free(job->slots[i].buffer);
+    }
+  }
+  free(job->slots);
+  free(job->free);
+  pthread_mutex_destroy(&job->lock);
+  return ok;
+}
+
+
+static void * histogram_create(const void * target) {
+  const struct Histogram * histogram = (const struct Histogram *) target;
+
+  return HistogramNew(HistogramBins(histogram), HistogramLeft(histogram), HistogramRight(histogram));
+}
+
+
+static void histogram_add(void * accumulator, const double * array, size_t size) {
+  HistogramAddArray((struct Histogram *) accumulator, array, size);
+}
+
+
+static void histogram_merge(void * target, const void * accumulator) {
+  HistogramMerge((struct Histogram *) target, (const struct Histogram *) accumulator);
+}
+
+
+static void histogram_release(void * accumulator) {
+  HistogramRelease((struct Histogram *) accumulator);
+}
+
+
+/**
+ * Parallel histogram of sampler output
+ */
+int crandom_parallel_histogram(struct Histogram * histogram, size_t samples, cRandomSampler sampler, void * ctx, int seed, int threads) {
+  struct PrivateJob job;
+
+  job.samples = samples;
+  job.sampler = sampler;
+  job.ctx = ctx;
+  job.target = histogram;
+  job.create = &histogram_create;
+  job.add = &histogram_add;
+  job.merge = &histogram_merge;
+  job.release = &histogram_release;
+
+  return private_run(&job, seed, threads);
+}
+
+
+static void * sketch_create(const void * target) {
+  return QuantileSketchNew(QuantileSketchCompression((const struct QuantileSketch *) target));
+}
+
+
+static void sketch_add(void * accumulator, const double * array, size_t size) {
+  QuantileSketchAddArray((struct QuantileSketch *) accumulator, array, size);
+}
+
+
+static void sketch_merge(void * target, const void * accumulator) {
+  QuantileSketchMerge((struct QuantileSketch *) target, (const struct QuantileSketch *) accumulator);
+}
+
+
+static void sketch_release(void * accumulator) {
+  QuantileSketchRelease((struct QuantileSketch *) accumulator);
+}
+
+
+/**
+ * Parallel quantile sketch of sampler output
+ */
+int crandom_parallel_quantiles(struct QuantileSketch * sketch, size_t samples, cRandomSampler sampler, void * ctx, int seed, int threads) {
+  struct PrivateJob job;
+
+  job.samples = samples;
+  job.sampler = sampler;
+  job.ctx = ctx;
+  job.target = sketch;
+  job.create = &sketch_create;
+  job.add = &sketch_add;
+  job.merge = &sketch_merge;
+  job.release = &sketch_release;
+
+  return private_run(&job, seed, threads);
+}
+
+
+struct MomentsJob {
+  size_t samples;
+  cRandomSampler sampler;
+  void * ctx;
+
+  struct Moments * partial;
+};
+
+
+static void moments_task(void * ctx, size_t task, struct cRandom * crandom) {
+  struct MomentsJob * job = (struct MomentsJob *) ctx;
+  double buffer[MOMENTS_BUFFER];
+  size_t offset = task * MOMENTS_TASK, end, block;
+
+  end = (job->samples - offset < MOMENTS_TASK) ? job->samples : offset + MOMENTS_TASK;
+
+  for(; offset < end; offset += block) {
+    block = (end - offset < MOMENTS_BUFFER) ? end - offset : MOMENTS_BUFFER;
+    job->sampler(job->ctx, crandom, buffer, block);
+    moments_add_array(&job->partial[task], buffer, block);
+  }
+}
+
+
+/**
+ * Parallel moments of sampler output
+ */
+int crandom_parallel_moments(struct Moments * moments, size_t samples, cRandomSampler sampler, void * ctx, int seed, int threads) {
+  const size_t tasks = (samples + MOMENTS_TASK - 1) / MOMENTS_TASK;
+  struct MomentsJob job;
+  size_t i, width;
+
+  if( tasks == 0 )
+    return 1;
+
+  job.samples = samples;
+  job.sampler = sampler;
+  job.ctx = ctx;
+  job.partial = (struct Moments *) malloc(tasks * sizeof(struct Moments));
+  if( job.partial == NULL )
+    return 0;
+
+  for(i = 0; i < tasks; ++i)
+    moments_init(&job.partial[i], moments->compensated);
+
+  if( !crandom_parallel_mc(tasks, &moments_task, &job, seed, threads) ) {
+    free(job.partial);
+    return 0;
+  }
+
+  /* pairwise merge in the task order */
+  for(width = 1; width < tasks; width *= 2) {
+    for(i = 0; i + width < tasks; i += 2 * width)
+      moments_merge(&job.partial[i], &job.partial[i + width]);
+  }
+  moments_merge(moments, &job.partial[0]);
+
+  free(job.partial);
+  return 1;
+}
+
+
+struct SequentialJob {
+  cRandomSampler sampler;
+  void * ctx;
+  size_t batch;
+
+  /* the round is batches first, first + 1, ... */
+  size_t first;
+  struct Moments * partial;
+  double * buffers;
+};
+
+
+static void sequential_task(void * ctx, size_t task, struct cRandom * crandom) {
+  struct SequentialJob * job = (struct SequentialJob *) ctx;
+  double * buffer = job->buffers + task * SEQUENTIAL_BUFFER;
+  size_t offset, block;
+
+  for(offset = 0; offset < job->batch; offset += block) {
+    block = (job->batch - offset < SEQUENTIAL_BUFFER) ? job->batch - offset : SEQUENTIAL_BUFFER;
+    job->sampler(job->ctx, crandom, buffer, block);
+    moments_add_array(&job->partial[task], buffer, block);
+  }
+}
+
+
+/**
+ * Sequential-stopping Monte Carlo
+ */
+int crandom_sequential_mc(struct Moments * moments, cRandomSampler sampler, void * ctx, size_t batch,
+                          double z, double halfWidth, size_t maxBatches, int seed, int threads) {
+  struct SequentialJob job;
+  size_t round, i;
+  int result = 0;
+
+  assert( 0 < batch );
+  assert( 0.0 < z && 0.0 < halfWidth );
+
+  if( threads <= 0 )
+    threads = crandom_thread_count();
+
+  job.sampler = sampler;
+  job.ctx = ctx;
+  job.batch = batch;
+  job.partial = (struct Moments *) malloc(threads * sizeof(struct Moments));
+  job.buffers = (double *) malloc(threads * SEQUENTIAL_BUFFER * sizeof(double));
+  if( job.partial == NULL || job.buffers == NULL ) {
+    result = -1;
+    goto done;
+  }
+
+  for(job.first = 0; job.first < maxBatches; job.first += round) {
+    round = (maxBatches - job.first < (size_t) threads) ? maxBatches - job.first : (size_t) threads;
+    for(i = 0; i < round; ++i)
+      moments_init(&job.partial[i], moments->compensated);
+
+    /* batch job.first + i gets the stream of its own index */
+    if( !run_tasks(job.first, round, &sequential_task, &job, seed, threads) ) {
+      result = -1;
+      goto done;
+    }
+
+    for(i = 0; i < round; ++i) {
+      moments_merge(moments, &job.partial[i]);
+      if( moments->n > 1.0 && z * sqrt(moments_variance(moments) / moments->n) <= halfWidth ) {
+        result = 1;
+        goto done;
+      }
+    }
+  }
+
+done:
+  free(job.partial);
+  free(job.buffers);
+  return result;
+}
@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __parallel_h__
+#define __parallel_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+#include "histogram.h"
+#include "moments.h"
+#include "quantile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Monte Carlo task: fn(ctx, task, crandom)
+ *
+ * crandom is the stream of the task; it is valid only during the call.
+ */
+typedef void (* cRandomTask)(void * ctx, size_t task, struct cRandom * crandom);
+
+
+/**
+ * Returns the number of online processors
+ */
+int crandom_thread_count(void);
+
+
+/**
+ * Runs tasks 0, ..., tasks - 1 on threads threads (POSIX threads) with
+ * work stealing; threads <= 0 means crandom_thread_count().
+ *
+ * The stream of a task is a dSFMT generator initialized by the key
+ * (seed, task), so it depends neither on the number of threads nor on
+ * the schedule: if every task writes its own results, they are
+ * bit-identical for any thread count.
+ *
+ * Returns 0 if there is not enough memory or threads, 1 otherwise.
+ */
+int crandom_parallel_mc(size_t tasks, cRandomTask fn, void * ctx, int seed, int threads);
+
+
+/**
+ * Parallel random_fill: fills array with the next size values of a dSFMT
+ * generator on threads threads (threads <= 0 means crandom_thread_count()).
+ *
+ * Every thread jumps a copy of the generator to the start of its chunk,
+ * so the output and the final state of crandom are bit-identical to
+ * random_fill(crandom, array, size) (and so to dsfmt_fill_array_close_open
+ * from the same state) for any thread count.
+ *
+ * NOTE: crandom must be created by dSFMTRandomNew*
+ *
+ * Returns 0 if there is not enough memory or threads, 1 otherwise; on
+ * failure array and crandom are unspecified.
+ */
+int crandom_parallel_fill(struct cRandom * crandom, double * array, size_t size, int threads);
+
+
+/**
+ * Sampler: fills array with size variates from crandom, usually by one of
+ * the *_fill functions, e.g. normal_fill(crandom, 0.0, 1.0, array, size).
+ */
+typedef void (* cRandomSampler)(void * ctx, struct cRandom * crandom, double * array, size_t size);
+
+
+/**
+ * Adds samples variates of sampler to histogram on threads threads
+ * (threads <= 0 means crandom_thread_count()).
+ *
+ * The variates are drawn in chunks by crandom_parallel_mc with the seed
+ * seed; every thread adds its chunks to a private histogram and the
+ * private histograms are merged at the end, so the counters do not
+ * depend on the thread count.
+ *
+ * Returns 0 if there is not enough memory or threads, 1 otherwise.
+ */
+int crandom_parallel_histogram(struct Histogram * histogram, size_t samples, cRandomSampler sampler, void * ctx, int seed, int threads);
+
+
+/**
+ * Adds samples variates of sampler to moments on threads threads
+ * (threads <= 0 means crandom_thread_count()).
+ *
+ * The variates are drawn in chunks by crandom_parallel_mc with the seed
+ * seed. Every chunk has its own accumulator; the accumulators are merged
+ * pairwise in the chunk order, so the result is bit-identical for any
+ * thread count.
+ *
+ * Returns 0 if there is not enough memory or threads, 1 otherwise.
+ */
+int crandom_parallel_moments(struct Moments * moments, size_t samples, cRandomSampler sampler, void * ctx, int seed, int threads);
+
+
+/**
+ * Adds samples variates of sampler to sketch on threads threads
+ * (threads <= 0 means crandom_thread_count()).
+ *
+ * The variates are drawn in chunks by crandom_parallel_mc with the seed
+ * seed; every thread folds its chunks into a private sketch and the
+ * private sketches are merged at the end. The variates do not depend on
+ * the thread count, but the centroids depend on the merge order, so the
+ * estimates agree within the accuracy of the sketch, not bit for bit.
+ *
+ * Returns 0 if there is not enough memory or threads, 1 otherwise.
+ */
+int crandom_parallel_quantiles(struct QuantileSketch * sketch, size_t samples, cRandomSampler sampler, void * ctx, int seed, int threads);
+
+
+/**
+ * Sequential-stopping Monte Carlo: runs batches of batch replications
+ * (sampler output values) until the confidence interval half-width
+ * z * sqrt(variance / n) of the mean is at most halfWidth, or maxBatches
+ * batches are done. The values are added to moments (initialized by the
+ * caller).
+ *
+ * Batches run on threads threads (threads <= 0 means
+ * crandom_thread_count()), one round of threads batches at a time.
+ * Batch b uses the stream of crandom_parallel_mc's task b with the seed
+ * seed, and the stopping rule is checked after every batch in the batch
+ * order, so the result depends neither on the thread count nor on the
+ * schedule; batches of the last round past the stopping point are
+ * discarded.
+ *
+ * Returns 1 when the precision is reached, 0 when it is not reached in
+ * maxBatches batches, -1 if there is not enough memory or threads.
+ */
+int crandom_sequential_mc(struct Moments * moments, cRandomSampler sampler, void * ctx, size_t batch,
+                          double z, double halfWidth, size_t maxBatches, int seed, int threads);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__parallel_h__*/
@@ -0,0 +1,22 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include "probes.h"
+
+
+#ifdef CRANDOM_PROBES
+
+int crandom_probes_enabled(void) {
+  return 1;
+}
+
+#else /* CRANDOM_PROBES */
+
+int crandom_probes_enabled(void) {
+  return 0;
+}
+
+#endif /* CRANDOM_PROBES */
@@ -0,0 +1,194 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __probes_h__
+#define __probes_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Static tracepoints (USDT) of the provider "crandom".
+ *
+ * A probe is a single nop plus an ELF note in the format of SystemTap's
+ * sys/sdt.h (emitted by the macros below, no header needed), so it costs
+ * nothing until a tracer attaches, e.g.
+ *
+ *   bpftrace -e 'usdt:./a.out:crandom:refill { @[arg0] = count(); }'
+ *
+ * Every probe has a semaphore that the tracer raises while attached; the
+ * checks that only feed a probe are skipped while it is zero.
+ *
+ * The probes are compiled on Linux x86-64 and AArch64 with GCC or Clang
+ * unless CRANDOM_NO_PROBES is defined; elsewhere they expand to nothing.
+ *
+ * All arguments are signed 64-bit integers; real numbers are passed in
+ * millionths (x * 1e6, truncated and clamped to +-9e18, NaN as 0), since
+ * bpftrace has no floating point.
+ *
+ *   refill(generator, wanted)
+ *     A dSFMT generator regenerates its block (dsfmt_gen_rand_all).
+ *     generator: address of the struct cRandom
+ *     wanted:    uniforms the call still needs, the refilled block included
+ *                (1 for crandom->next, the rest of the array for random_fill)
+ *
+ *   poisson_loop(iterations, mean)
+ *     Poisson took more than CRANDOM_PROBE_LOOP uniforms.
+ *     iterations: uniforms taken
+ *     mean:       m in millionths
+ *
+ *   gillespie_loop(iterations, group)
+ *     The reaction selection of GillespieStep/GillespieRun rejected more
+ *     than CRANDOM_PROBE_LOOP members in a row.
+ *     iterations: members tried
+ *     group:      exponent of the propensity group
+ *
+ *   nhpp_loop(iterations, time)
+ *     The thinning of NhppFill rejected more than CRANDOM_PROBE_LOOP
+ *     proposals before an event (counted within one call).
+ *     iterations: proposals rejected before the event
+ *     time:       time of the event in millionths
+ *
+ *   walk_loop(iterations, node)
+ *     A second order step of RandomWalkFill rejected more than
+ *     CRANDOM_PROBE_LOOP candidates.
+ *     iterations: candidates tried
+ *     node:       current node of the walker
+ *
+ *   normal_tail(generator, z)
+ *     normal or normal_fill returned a variate at least
+ *     CRANDOM_PROBE_NORMAL_TAIL standard deviations from the mean.
+ *     generator: address of the struct cRandom
+ *     z:         standardized variate (x - m) / s in millionths
+ *
+ *   exponential_tail(generator, z)
+ *     exponential or exponential_fill returned a variate at least
+ *     CRANDOM_PROBE_EXPONENTIAL_TAIL means.
+ *     generator: address of the struct cRandom
+ *     z:         x / m in millionths
+ */
+
+
+/* Iterations of a loop that fire its *_loop probe */
+#ifndef CRANDOM_PROBE_LOOP
+#define CRANDOM_PROBE_LOOP (64)
+#endif
+
+/* Standard deviations of a normal tail (probability 5.7e-7) */
+#ifndef CRANDOM_PROBE_NORMAL_TAIL
+#define CRANDOM_PROBE_NORMAL_TAIL (5.0)
+#endif
+
+/* Means of an exponential tail (probability 3.1e-7) */
+#ifndef CRANDOM_PROBE_EXPONENTIAL_TAIL
+#define CRANDOM_PROBE_EXPONENTIAL_TAIL (15.0)
+#endif
+
+
+/**
+ * Returns 1 if the probes are compiled in, 0 otherwise
+ */
+int crandom_probes_enabled(void);
+
+
+#if !defined(CRANDOM_NO_PROBES) && (defined(__GNUC__) || defined(__clang__)) && \
+    defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define CRANDOM_PROBES
+#endif
+
+
+#ifdef CRANDOM_PROBES
+
+/*
+ * Semaphores, raised by the tracers, which find them by the addresses in
+ * the notes. They are weak so that every file with probes can define them
+ * and no extra object has to be linked.
+ */
+#define CRANDOM_PROBE_SEMAPHORE(name) \
+  __attribute__((weak, section(".probes"))) volatile unsigned short crandom_##name##_semaphore = 0
+
+CRANDOM_PROBE_SEMAPHORE(refill);
+CRANDOM_PROBE_SEMAPHORE(poisson_loop);
+CRANDOM_PROBE_SEMAPHORE(gillespie_loop);
+CRANDOM_PROBE_SEMAPHORE(nhpp_loop);
+CRANDOM_PROBE_SEMAPHORE(walk_loop);
+CRANDOM_PROBE_SEMAPHORE(normal_tail);
+CRANDOM_PROBE_SEMAPHORE(exponential_tail);
+
+/**
+ * Returns nonzero while a tracer is attached to the probe name
+ */
+#define CRANDOM_PROBE_ENABLED(name) __builtin_expect(crandom_##name##_semaphore != 0, 0)
+
+/*
+ * The nop and its note: version 3 stapsdt note with the address of the
+ * nop, of _.stapsdt.base (for prelink) and of the semaphore, then the
+ * provider, the name and the argument specifications "-8@operand".
+ */
+#define CRANDOM_PROBE_ASM(name, args)                                           \
+  "990: nop\n"                                                                  \
+  ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                 \
+  ".balign 4\n"                                                                 \
+  ".4byte 992f-991f, 994f-993f, 3\n"                                            \
+  "991: .asciz \"stapsdt\"\n"                                                   \
+  "992: .balign 4\n"                                                            \
+  "993: .8byte 990b\n"                                                          \
+  ".8byte _.stapsdt.base\n"                                                     \
+  ".8byte crandom_" #name "_semaphore\n"                                        \
+  ".asciz \"crandom\"\n"                                                        \
+  ".asciz \"" #name "\"\n"                                                      \
+  ".asciz \"" args "\"\n"                                                       \
+  "994: .balign 4\n"                                                            \
+  ".popsection\n"                                                               \
+  ".ifndef _.stapsdt.base\n"                                                    \
+  ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"       \
+  ".weak _.stapsdt.base\n"                                                      \
+  ".hidden _.stapsdt.base\n"                                                    \
+  "_.stapsdt.base: .space 1\n"                                                  \
+  ".size _.stapsdt.base, 1\n"                                                   \
+  ".popsection\n"                                                               \
+  ".endif\n"
+
+/*
+ * long long is not C89; __extension__ keeps -pedantic quiet in the C89
+ * sources that include this header (the probes are GCC/Clang-only).
+ */
+
+/**
+ * Converts a real number to millionths, clamped to the range of long long
+ *
+ * NOTE: x is evaluated more than once.
+ */
+#define CRANDOM_PROBE_MICRO(x)                                                  \
+  (__extension__ ((x) >= 9e12 ? 9000000000000000000LL :                         \
+                  (x) <= -9e12 ? -9000000000000000000LL :                       \
+                  (x) == (x) ? (long long) ((x) * 1e6) : 0LL))
+
+/**
+ * Fires the probe name with two arguments
+ */
+#define CRANDOM_PROBE2(name, x0, x1)                                            \
+  __asm__ __volatile__ (CRANDOM_PROBE_ASM(name, "-8@%[a0] -8@%[a1]")            \
+                        : : [a0] "nor" (__extension__ (long long) (x0)),        \
+                            [a1] "nor" (__extension__ (long long) (x1)))
+
+#else
+
+#define CRANDOM_PROBE_ENABLED(name) 0
+#define CRANDOM_PROBE_MICRO(x) 0
+#define CRANDOM_PROBE2(name, x0, x1) ((void) 0)
+
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__probes_h__*/
@@ -0,0 +1,301 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "quantile.h"
+
+
+/* Size of the buffer of unmerged values, in compressions */
+#define QUANTILE_BUFFER (8)
+
+
+struct QuantileSketch {
+  double compression;
+  int capacity;
+
+  /* centroids, sorted by mean */
+  int centroids;
+  double * mean;
+  double * weight;
+  double total;
+
+  /* unmerged values */
+  int buffered;
+  int bufferSize;
+  double * buffer;
+
+  double min;
+  double max;
+
+  /* merge space */
+  double * mergeMean;
+  double * mergeWeight;
+};
+
+
+/**
+ * Create a new empty sketch
+ */
+struct QuantileSketch * QuantileSketchNew(double compression) {
+  struct QuantileSketch * sketch;
+
+  assert( 10.0 <= compression );
+
+  sketch = (struct QuantileSketch *) calloc(1, sizeof(*sketch));
+  if( sketch == NULL )
+    return NULL;
+
+  sketch->compression = compression;
+  sketch->capacity = 2 * (int) ceil(compression) + 8;
+  sketch->bufferSize = QUANTILE_BUFFER * (int) ceil(compression);
+  sketch->min = HUGE_VAL;
+  sketch->max = -HUGE_VAL;
+
+  sketch->mean = (double *) malloc(sketch->capacity * sizeof(double));
+  sketch->weight = (double *) malloc(sketch->capacity * sizeof(double));
+  sketch->buffer = (double *) malloc(sketch->bufferSize * sizeof(double));
+  sketch->mergeMean = (double *) malloc((sketch->capacity + sketch->bufferSize) * sizeof(double));
+  sketch->mergeWeight = (double *) malloc((sketch->capacity + sketch->bufferSize) * sizeof(double));
+  if( sketch->mean == NULL || sketch->weight == NULL || sketch->buffer == NULL ||
+      sketch->mergeMean == NULL || sketch->mergeWeight == NULL ) {
+    QuantileSketchRelease(sketch);
+    return NULL;
+  }
+
+  return sketch;
+}
+
+
+/**
+ * Releases resources of a QuantileSketch object
+ */
+void QuantileSketchRelease(struct QuantileSketch * sketch) {
+  if( sketch == NULL )
+    return;
+
+  free(sketch->mean);
+  free(sketch->weight);
+  free(sketch->buffer);
+  free(sketch->mergeMean);
+  free(sketch->mergeWeight);
+  free(sketch);
+}
+
+
+/**
+ * Returns the largest quantile that a centroid starting at q may reach
+ * for total weight n: k(q) + 1 mapped back, with the logarithmic scale
+ * k(q) = compression / z log(q / (1 - q)), z = 4 log(n / compression) + 24
+ * (Dunning's k2), so the centroid size is about q (1 - q) z / compression.
+ */
+static double quantile_limit(double compression, double n, double q) {
+  double z, k;
+
+  if( q <= 0.0 )
+    return 0.0;
+  if( q >= 1.0 )
+    return 1.0;
+
+  z = (n > compression) ? 4.0 * log(n / compression) + 24.0 : 24.0;
+  k = log(q / (1.0 - q)) + z / compression;
+
+  return 1.0 / (1.0 + exp(-k));
+}
+
+
+/**
+ * Folds the sorted (mergeMean, mergeWeight) of size n into the centroids
+ */
+static void compress(struct QuantileSketch * sketch, int n, double total) {
+  const double * mean = sketch->mergeMean;
+  const double * weight = sketch->mergeWeight;
+  double sofar = 0.0, limit, w;
+  int i, c = 0;
+
+  if( n == 0 )
+    return;
+
+  sketch->mean[0] = mean[0];
+  sketch->weight[0] = weight[0];
+  limit = total * quantile_limit(sketch->compression, total, 0.0);
+
+  for(i = 1; i < n; ++i) {
+    w = sketch->weight[c];
+    if( sofar + w + weight[i] <= limit || c + 1 == sketch->capacity ) {
+      /* join the current centroid */
+      sketch->weight[c] = w + weight[i];
+      sketch->mean[c] += (mean[i] - sketch->mean[c]) * weight[i] / sketch->weight[c];
+    } else {
+      sofar += w;
+      limit = total * quantile_limit(sketch->compression, total, sofar / total);
+      ++c;
+      sketch->mean[c] = mean[i];
+      sketch->weight[c] = weight[i];
+    }
+  }
+
+  sketch->centroids = c + 1;
+  sketch->total = total;
+}
+
+
+static int compare_doubles(const void * lhs, const void * rhs) {
+  const double l = *(const double *) lhs;
+  const double r = *(const double *) rhs;
+
+  return (l < r) ? -1 : (r < l) ? 1 : 0;
+}
+
+
+/**
+ * Merges the sorted list (mean, weight) of size n with the centroids
+ * into the merge space and returns its size
+ */
+static int merge_sorted(struct QuantileSketch * sketch, const double * mean, const double * weight, int n) {
+  int i = 0, j = 0, k = 0;
+
+  while( i < sketch->centroids || j < n ) {
+    if( j == n || (i < sketch->centroids && sketch->mean[i] <= mean[j]) ) {
+      sketch->mergeMean[k] = sketch->mean[i];
+      sketch->mergeWeight[k++] = sketch->weight[i++];
+    } else {
+      sketch->mergeMean[k] = mean[j];
+      sketch->mergeWeight[k++] = (weight != NULL) ? weight[j] : 1.0;
+      ++j;
+    }
+  }
+
+  return k;
+}
+
+
+/**
+ * Folds the buffered values into the centroids
+ */
+static void flush(struct QuantileSketch * sketch) {
+  int n;
+
+  if( sketch->buffered == 0 )
+    return;
+
+  qsort(sketch->buffer, sketch->buffered, sizeof(double), &compare_doubles);
+  if( sketch->buffer[0] < sketch->min )
+    sketch->min = sketch->buffer[0];
+  if( sketch->buffer[sketch->buffered - 1] > sketch->max )
+    sketch->max = sketch->buffer[sketch->buffered - 1];
+
+  n = merge_sorted(sketch, sketch->buffer, NULL, sketch->buffered);
+  compress(sketch, n, sketch->total + sketch->buffered);
+  sketch->buffered = 0;
+}
+
+
+/**
+ * Adds one value
+ */
+void QuantileSketchAdd(struct QuantileSketch * sketch, double x) {
+  QuantileSketchAddArray(sketch, &x, 1);
+}
+
+
+/**
+ * Adds size values
+ */
+void QuantileSketchAddArray(struct QuantileSketch * sketch, const double * array, size_t size) {
+  size_t offset;
+  int n;
+
+  for(offset = 0; offset < size; offset += n) {
+    n = sketch->bufferSize - sketch->buffered;
+    if( (size_t) n > size - offset )
+      n = (int) (size - offset);
+
+    memcpy(sketch->buffer + sketch->buffered, array + offset, n * sizeof(double));
+    sketch->buffered += n;
+    if( sketch->buffered == sketch->bufferSize )
+      flush(sketch);
+  }
+}
+
+
+/**
+ * Adds the values summarized by source to sketch
+ */
+void QuantileSketchMerge(struct QuantileSketch * sketch, const struct QuantileSketch * source) {
+  int n;
+
+  assert( sketch->compression == source->compression );
+
+  flush(sketch);
+
+  n = merge_sorted(sketch, source->mean, source->weight, source->centroids);
+  compress(sketch, n, sketch->total + source->total);
+  if( source->min < sketch->min )
+    sketch->min = source->min;
+  if( source->max > sketch->max )
+    sketch->max = source->max;
+
+  QuantileSketchAddArray(sketch, source->buffer, source->buffered);
+}
+
+
+/**
+ * Returns the compression
+ */
+double QuantileSketchCompression(const struct QuantileSketch * sketch) {
+  return sketch->compression;
+}
+
+
+/**
+ * Returns the number of added values
+ */
+double QuantileSketchCount(const struct QuantileSketch * sketch) {
+  return sketch->total + sketch->buffered;
+}
+
+
+/**
+ * Returns the estimate of the q-quantile
+ */
+double QuantileSketchQuantile(struct QuantileSketch * sketch, double q) {
+  const double * mean = sketch->mean;
+  const double * weight = sketch->weight;
+  double index, sofar, step;
+  int n, i;
+
+  assert( 0.0 <= q && q <= 1.0 );
+
+  flush(sketch);
+  n = sketch->centroids;
+  if( n == 0 )
+    return sqrt(-1.0);
+  if( n == 1 )
+    return mean[0];
+
+  /* centroid i covers its weight around its mean; interpolate between
+     the centers and towards min and max at the ends */
+  index = q * sketch->total;
+  if( index < weight[0] / 2.0 )
+    return sketch->min + (mean[0] - sketch->min) * index / (weight[0] / 2.0);
+
+  sofar = weight[0] / 2.0;
+  for(i = 0; i + 1 < n; ++i) {
+    step = (weight[i] + weight[i + 1]) / 2.0;
+    if( sofar + step > index )
+      return mean[i] + (mean[i + 1] - mean[i]) * (index - sofar) / step;
+    sofar += step;
+  }
+
+  step = weight[n - 1] / 2.0;
+  if( index - sofar >= step )
+    return sketch->max;
+  return mean[n - 1] + (sketch->max - mean[n - 1]) * (index - sofar) / step;
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __quantile_h__
+#define __quantile_h__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Streaming quantile sketch (merging t-digest, Dunning and Ertl)
+ *
+ * Values are summarized by weighted centroids whose size is limited by
+ * a logarithmic scale function, so the centroids are small near q = 0 and
+ * q = 1 and tail quantiles are accurate. The memory depends only on the
+ * compression, not on the number of values.
+ */
+struct QuantileSketch;
+
+
+/**
+ * Create a new empty sketch; compression (about 100 to 1000) bounds
+ * the number of centroids, larger is more accurate.
+ * NOTE: use compression >= 10.0
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct QuantileSketch * QuantileSketchNew(double compression);
+
+
+/**
+ * Releases resources of a QuantileSketch object
+ */
+void QuantileSketchRelease(struct QuantileSketch * sketch);
+
+
+/**
+ * Adds one value
+ */
+void QuantileSketchAdd(struct QuantileSketch * sketch, double x);
+
+
+/**
+ * Adds size values, e.g. the output of one of the *_fill functions.
+ * Values are buffered and folded into the centroids in sorted batches.
+ */
+void QuantileSketchAddArray(struct QuantileSketch * sketch, const double * array, size_t size);
+
+
+/**
+ * Adds the values summarized by source to sketch
+ * NOTE: both must have the same compression
+ */
+void QuantileSketchMerge(struct QuantileSketch * sketch, const struct QuantileSketch * source);
+
+
+/**
+ * Returns the compression
+ */
+double QuantileSketchCompression(const struct QuantileSketch * sketch);
+
+
+/**
+ * Returns the number of added values
+ */
+double QuantileSketchCount(const struct QuantileSketch * sketch);
+
+
+/**
+ * Returns the estimate of the q-quantile, 0 <= q <= 1
+ * (NaN for an empty sketch)
+ */
+double QuantileSketchQuantile(struct QuantileSketch * sketch, double q);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__quantile_h__*/
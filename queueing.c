@@ -0,0 +1,453 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queueing.h"
+#include "des.h"
+#include "quantile.h"
+
+
+/* Number of service times drawn per batch */
+#define QUEUE_BATCH (256)
+
+/* Number of customers allocated at once by the arena */
+#define QUEUE_ARENA_CHUNK (4096)
+
+/* Maximal number of priority classes */
+#define QUEUE_MAX_CLASSES (16)
+
+
+static const double quantileLevels[QUEUE_QUANTILES] = { 0.5, 0.9, 0.99 };
+
+
+/* Compression of the quantile sketches */
+#define QUEUE_COMPRESSION (200.0)
+
+
+/**
+ * Streaming statistics of a time sample; quantiles come from a
+ * QuantileSketch, so the samples are not stored
+ */
+struct TimeStats {
+  size_t count;
+  double sum;
+
+  struct QuantileSketch * sketch;
+};
+
+
+static void stats_add(struct TimeStats * stats, double x) {
+  stats->count++;
+  stats->sum += x;
+  QuantileSketchAdd(stats->sketch, x);
+}
+
+
+static void stats_report(struct TimeStats * stats, struct QueueReport * report) {
+  int i;
+
+  report->customers = stats->count;
+  report->mean = stats->count ? stats->sum / stats->count : 0.0;
+  for(i = 0; i < QUEUE_QUANTILES; ++i)
+    report->quantiles[i] = stats->count ? QuantileSketchQuantile(stats->sketch, quantileLevels[i]) : 0.0;
+}
+
+
+/*************
+ * Simulator *
+ *************/
+
+
+struct QueueNetwork {
+  int stations;
+  struct QueueStation * spec;
+  double * routing;        /* stations x stations, copied */
+
+  int classes;
+  double classCdf[QUEUE_MAX_CLASSES];
+};
+
+
+struct Customer {
+  double entered;          /* time of entering the network */
+  double queued;           /* time of entering the current queue */
+  int cls;
+  struct Customer * next;
+};
+
+
+struct CustomerChunk {
+  struct CustomerChunk * next;
+  struct Customer customers[QUEUE_ARENA_CHUNK];
+};
+
+
+struct StationState {
+  int busy;
+  struct Customer * head[QUEUE_MAX_CLASSES];
+  struct Customer * tail[QUEUE_MAX_CLASSES];
+
+  double service[QUEUE_BATCH];
+  int used;
+
+  double lastChange;
+  double busyTime;         /* integral of busy servers after warmup */
+
+  struct TimeStats wait;
+};
+
+
+struct Replication {
+  const struct QueueNetwork * net;
+  double warmup;
+  int failed;
+
+  struct StationState * state;
+  struct TimeStats sojourn;
+
+  struct CustomerChunk * chunks;
+  struct Customer * free;
+};
+
+
+enum { EVENT_ARRIVAL, EVENT_DEPARTURE };
+
+
+static struct Customer * customer_alloc(struct Replication * rep) {
+  struct CustomerChunk * chunk;
+  struct Customer * customer;
+  int i;
+
+  if( rep->free == NULL ) {
+    chunk = (struct CustomerChunk *) malloc(sizeof(*chunk));
+    if( chunk == NULL )
+      return NULL;
+    chunk->next = rep->chunks;
+    rep->chunks = chunk;
+    for(i = QUEUE_ARENA_CHUNK - 1; i >= 0; --i) {
+      chunk->customers[i].next = rep->free;
+      rep->free = &chunk->customers[i];
+    }
+  }
+
+  customer = rep->free;
+  rep->free = customer->next;
+  return customer;
+}
+
+
+static void customer_free(struct Replication * rep, struct Customer * customer) {
+  customer->next = rep->free;
+  rep->free = customer;
+}
+
+
+/**
+ * Returns the next service time of station s; they are drawn in batches
+ */
+static double service_time(struct DesSimulation * sim, struct Replication * rep, int s) {
+  const struct QueueStation * spec = &rep->net->spec[s];
+  struct StationState * state = &rep->state[s];
+  struct cRandom * crandom;
+  double extra[QUEUE_BATCH];
+  int i, k;
+
+  if( state->used == QUEUE_BATCH ) {
+    crandom = DesStream(sim, 2 * s + 1);
+    if( crandom == NULL ) {
+      rep->failed = 1;
+      return 0.0;
+    }
+    switch( spec->service ) {
+    case SERVICE_EXPONENTIAL:
+      exponential_fill(crandom, spec->a, state->service, QUEUE_BATCH);
+      break;
+    case SERVICE_ERLANG:
+      exponential_fill(crandom, spec->a, state->service, QUEUE_BATCH);
+      for(k = 1; k < spec->n; ++k) {
+        exponential_fill(crandom, spec->a, extra, QUEUE_BATCH);
+        for(i = 0; i < QUEUE_BATCH; ++i)
+          state->service[i] += extra[i];
+      }
+      break;
+    case SERVICE_LOGNORMAL:
+      normal_fill(crandom, spec->a, spec->b, state->service, QUEUE_BATCH);
+      for(i = 0; i < QUEUE_BATCH; ++i)
+        state->service[i] = exp(state->service[i]);
+      break;
+    case SERVICE_UNIFORM:
+      uniform_fill(crandom, spec->a, spec->b, state->service, QUEUE_BATCH);
+      break;
+    case SERVICE_DETERMINISTIC:
+      for(i = 0; i < QUEUE_BATCH; ++i)
+        state->service[i] = spec->a;
+      break;
+    }
+    state->used = 0;
+  }
+
+  return state->service[state->used++];
+}
+
+
+/**
+ * Accumulates the busy time of station s up to now
+ */
+static void account_busy(struct Replication * rep, int s, double now) {
+  struct StationState * state = &rep->state[s];
+  double from = state->lastChange > rep->warmup ? state->lastChange : rep->warmup;
+
+  if( now > from )
+    state->busyTime += state->busy * (now - from);
+  state->lastChange = now;
+}
+
+
+static void start_service(struct DesSimulation * sim, struct Replication * rep, int s, struct Customer * customer) {
+  const double now = DesNow(sim);
+  struct StationState * state = &rep->state[s];
+
+  if( customer->queued >= rep->warmup )
+    stats_add(&state->wait, now - customer->queued);
+
+  account_busy(rep, s, now);
+  state->busy++;
+  if( DesSchedule(sim, now + service_time(sim, rep, s), EVENT_DEPARTURE, s, customer) == NULL )
+    rep->failed = 1;
+}
+
+
+static void enter_station(struct DesSimulation * sim, struct Replication * rep, int s, struct Customer * customer) {
+  struct StationState * state = &rep->state[s];
+  const int cls = (rep->net->spec[s].discipline == QUEUE_PRIORITY) ? customer->cls : 0;
+
+  customer->queued = DesNow(sim);
+  if( state->busy < rep->net->spec[s].servers ) {
+    start_service(sim, rep, s, customer);
+    return;
+  }
+
+  customer->next = NULL;
+  if( state->tail[cls] == NULL )
+    state->head[cls] = customer;
+  else
+    state->tail[cls]->next = customer;
+  state->tail[cls] = customer;
+}
+
+
+static void handle(struct DesSimulation * sim, const struct DesEvent * event, void * ctx) {
+  struct Replication * rep = (struct Replication *) ctx;
+  const struct QueueNetwork * net = rep->net;
+  const int s = event->entity;
+  struct StationState * state = &rep->state[s];
+  struct Customer * customer;
+  struct cRandom * crandom;
+  double u;
+  int k, c;
+
+  if( event->type == EVENT_ARRIVAL ) {
+    crandom = DesStream(sim, 2 * s);
+    if( crandom == NULL ||
+        DesSchedule(sim, DesNow(sim) + exponential(crandom, 1.0 / net->spec[s].arrivalRate), EVENT_ARRIVAL, s, NULL) == NULL ||
+        (customer = customer_alloc(rep)) == NULL ) {
+      rep->failed = 1;
+      DesStop(sim);
+      return;
+    }
+
+    customer->entered = DesNow(sim);
+    u = crandom->next(crandom);
+    for(c = 0; c + 1 < net->classes && u >= net->classCdf[c]; ++c)
+      ;
+    customer->cls = c;
+    enter_station(sim, rep, s, customer);
+    if( rep->failed )
+      DesStop(sim);
+    return;
+  }
+
+  /* departure: route the customer, then serve the next one */
+  customer = (struct Customer *) event->data;
+  account_busy(rep, s, DesNow(sim));
+  state->busy--;
+
+  crandom = DesStream(sim, 2 * s + 1);
+  if( crandom == NULL ) {
+    rep->failed = 1;
+    DesStop(sim);
+    return;
+  }
+  u = crandom->next(crandom);
+  for(k = 0; k < net->stations; ++k) {
+    u -= net->routing[s * net->stations + k];
+    if( u < 0.0 )
+      break;
+  }
+  if( k < net->stations ) {
+    enter_station(sim, rep, k, customer);
+  } else {
+    if( customer->entered >= rep->warmup )
+      stats_add(&rep->sojourn, DesNow(sim) - customer->entered);
+    customer_free(rep, customer);
+  }
+
+  for(c = 0; c < QUEUE_MAX_CLASSES; ++c) {
+    if( state->head[c] != NULL && state->busy < net->spec[s].servers ) {
+      customer = state->head[c];
+      state->head[c] = customer->next;
+      if( state->head[c] == NULL )
+        state->tail[c] = NULL;
+      start_service(sim, rep, s, customer);
+      break;
+    }
+  }
+
+  if( rep->failed )
+    DesStop(sim);
+}
+
+
+/**
+ * Create a new queueing network
+ */
+struct QueueNetwork * QueueNetworkNew(int stations, const struct QueueStation * spec, int classes, const double * classProbabilities) {
+  struct QueueNetwork * net;
+  double sum = 0.0;
+  int s, k;
+
+  assert( 0 < stations );
+  assert( 0 < classes && classes <= QUEUE_MAX_CLASSES );
+
+  net = (struct QueueNetwork *) calloc(1, sizeof(*net));
+  if( net == NULL )
+    return NULL;
+
+  net->stations = stations;
+  net->spec = (struct QueueStation *) malloc(stations * sizeof(struct QueueStation));
+  net->routing = (double *) calloc(stations * stations, sizeof(double));
+  if( net->spec == NULL || net->routing == NULL ) {
+    QueueNetworkRelease(net);
+    return NULL;
+  }
+
+  memcpy(net->spec, spec, stations * sizeof(struct QueueStation));
+  for(s = 0; s < stations; ++s) {
+    assert( 0 < spec[s].servers );
+    assert( spec[s].service != SERVICE_ERLANG || 0 < spec[s].n );
+    net->spec[s].routing = NULL;
+    if( spec[s].routing != NULL ) {
+      for(k = 0; k < stations; ++k)
+        net->routing[s * stations + k] = spec[s].routing[k];
+    }
+  }
+
+  net->classes = classes;
+  for(k = 0; k < classes; ++k) {
+    sum += (classProbabilities != NULL) ? classProbabilities[k] : 1.0 / classes;
+    net->classCdf[k] = sum;
+  }
+
+  return net;
+}
+
+
+/**
+ * Releases resources of a QueueNetwork object
+ */
+void QueueNetworkRelease(struct QueueNetwork * net) {
+  if( net == NULL )
+    return;
+
+  free(net->routing);
+  free(net->spec);
+  free(net);
+}
+
+
+/**
+ * Runs one replication
+ */
+int QueueNetworkSimulate(const struct QueueNetwork * net, int seed, double warmup, double horizon, struct QueueReport * report) {
+  struct Replication rep;
+  struct DesSimulation * sim;
+  struct CustomerChunk * chunk;
+  struct cRandom * crandom;
+  int s, ok = 0;
+
+  assert( 0.0 <= warmup && warmup < horizon );
+
+  memset(&rep, 0, sizeof(rep));
+  rep.net = net;
+  rep.warmup = warmup;
+
+  rep.state = (struct StationState *) calloc(net->stations, sizeof(struct StationState));
+  rep.sojourn.sketch = QuantileSketchNew(QUEUE_COMPRESSION);
+  sim = DesSimulationNew(2 * net->stations, seed, &handle, &rep);
+  if( rep.state == NULL || rep.sojourn.sketch == NULL || sim == NULL )
+    goto done;
+
+  for(s = 0; s < net->stations; ++s) {
+    rep.state[s].used = QUEUE_BATCH;
+    rep.state[s].wait.sketch = QuantileSketchNew(QUEUE_COMPRESSION);
+    if( rep.state[s].wait.sketch == NULL )
+      goto done;
+    if( net->spec[s].arrivalRate > 0.0 ) {
+      crandom = DesStream(sim, 2 * s);
+      if( crandom == NULL ||
+          DesSchedule(sim, exponential(crandom, 1.0 / net->spec[s].arrivalRate), EVENT_ARRIVAL, s, NULL) == NULL )
+        goto done;
+    }
+  }
+
+  DesRun(sim, horizon);
+  if( rep.failed )
+    goto done;
+
+  for(s = 0; s < net->stations; ++s) {
+    account_busy(&rep, s, horizon);
+    stats_report(&rep.state[s].wait, &report[s]);
+    report[s].utilization = rep.state[s].busyTime / (net->spec[s].servers * (horizon - warmup));
+  }
+  stats_report(&rep.sojourn, &report[net->stations]);
+  report[net->stations].utilization = 0.0;
+  ok = 1;
+
+done:
+  DesSimulationRelease(sim);
+  while( rep.chunks != NULL ) {
+    chunk = rep.chunks;
+    rep.chunks = chunk->next;
+    free(chunk);
+  }
+  if( rep.state != NULL ) {
+    for(s = 0; s < net->stations; ++s)
+      QuantileSketchRelease(rep.state[s].wait.sketch);
+  }
+  QuantileSketchRelease(rep.sojourn.sketch);
+  free(rep.state);
+  return ok;
+}
+
+
+/**
+ * Runs independent replications in parallel
+ */
+int QueueNetworkReplicate(const struct QueueNetwork * net, int replications, int seed, double warmup, double horizon, struct QueueReport * report) {
+  int r, succeeded = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:succeeded)
+#endif
+  for(r = 0; r < replications; ++r)
+    succeeded += QueueNetworkSimulate(net, seed + r, warmup, horizon, report + r * (net->stations + 1));
+
+  return succeeded;
+}
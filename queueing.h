@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __queueing_h__
+#define __queueing_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Service discipline of a station
+ */
+enum QueueDiscipline {
+  QUEUE_FIFO,    /* first come, first served                           */
+  QUEUE_PRIORITY /* non-preemptive, class 0 first, FIFO within a class */
+};
+
+
+/**
+ * Service time distribution of a station
+ */
+enum QueueService {
+  SERVICE_EXPONENTIAL,   /* exponential(a)              */
+  SERVICE_ERLANG,        /* erlang(n, a)                */
+  SERVICE_LOGNORMAL,     /* lognormal(a, b)             */
+  SERVICE_UNIFORM,       /* uniform(a, b)               */
+  SERVICE_DETERMINISTIC  /* a                           */
+};
+
+
+/**
+ * Multi-server station
+ *
+ * External customers arrive at the station as a Poisson process with rate
+ * arrivalRate (0.0 for none). After the service a customer goes to
+ * station k with probability routing[k]; with the remaining probability
+ * it leaves the network. routing may be NULL (every customer leaves).
+ */
+struct QueueStation {
+  int servers;
+  enum QueueDiscipline discipline;
+
+  enum QueueService service;
+  int n;
+  double a;
+  double b;
+
+  double arrivalRate;
+  const double * routing;
+};
+
+
+/* Estimated quantiles: 0.5, 0.9, 0.99 */
+#define QUEUE_QUANTILES (3)
+
+
+/**
+ * Statistics of one station or of the whole network
+ *
+ * For a station the times are waiting times in the queue, for the whole
+ * network they are sojourn times. Quantiles come from a QuantileSketch
+ * (quantile.h) without storing the samples.
+ */
+struct QueueReport {
+  size_t customers;
+  double mean;
+  double quantiles[QUEUE_QUANTILES];
+  double utilization;
+};
+
+
+/**
+ * Queueing network
+ */
+struct QueueNetwork;
+
+
+/**
+ * Create a new queueing network
+ *
+ * Arriving customers get the priority class c with probability
+ * classProbabilities[c], c = 0, ..., classes - 1 (NULL for one class).
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct QueueNetwork * QueueNetworkNew(int stations, const struct QueueStation * spec, int classes, const double * classProbabilities);
+
+
+/**
+ * Releases resources of a QueueNetwork object
+ */
+void QueueNetworkRelease(struct QueueNetwork * net);
+
+
+/**
+ * Runs one replication on [0, horizon); statistics are collected after
+ * warmup. report must hold stations + 1 entries: one per station and
+ * the whole network last.
+ *
+ * Returns 0 if there is not enough memory, 1 otherwise.
+ */
+int QueueNetworkSimulate(const struct QueueNetwork * net, int seed, double warmup, double horizon, struct QueueReport * report);
+
+
+/**
+ * Runs independent replications in parallel (OpenMP, if enabled).
+ * Replication r uses the seed seed + r and writes its stations + 1
+ * entries to report + r * (stations + 1).
+ *
+ * Returns the number of successful replications.
+ */
+int QueueNetworkReplicate(const struct QueueNetwork * net, int replications, int seed, double warmup, double horizon, struct QueueReport * report);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__queueing_h__*/
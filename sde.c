@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "sde.h"
+
+
+/* Number of paths advanced together */
+#define SDE_BLOCK (256)
+
+
+/**
+ * Converts uniforms u[0..n) into Poisson(m) counts by inversion
+ * (one uniform per count, m is small: it is the jump rate times dt)
+ */
+static void poisson_counts(double * u, size_t n, double m) {
+  const double e = exp(-m);
+  double p, f;
+  size_t i;
+  int k;
+
+  for(i = 0; i < n; ++i) {
+    k = 0;
+    p = f = e;
+    while( f <= u[i] && k < 1000 ) {
+      ++k;
+      p *= m / k;
+      f += p;
+    }
+    u[i] = (double) k;
+  }
+}
+
+
+/**
+ * Simulates paths paths of the model
+ */
+int sde_simulate(const struct SdeModel * model, enum SdeScheme scheme, double horizon, int steps,
+                 struct cRandom * crandom, size_t paths,
+                 void (* observe)(void * ctx, int step, size_t first, const double * x, size_t n), void * ctx) {
+  const double dt = horizon / steps;
+  const double sqdt = sqrt(dt);
+  const int milstein = (scheme == SDE_MILSTEIN);
+  const int jumps = (model->jumpIntensity > 0.0);
+  double * buffer;
+  double * x;
+  double * dw;
+  double * a;
+  double * b;
+  double * db;
+  double * k;
+  double * zj;
+  size_t start, n, i;
+  int step;
+
+  assert( 0 < steps && 0.0 < horizon );
+  assert( model->drift == NULL || model->diffusion != NULL );
+
+  buffer = (double *) malloc(7 * SDE_BLOCK * sizeof(double));
+  if( buffer == NULL )
+    return 0;
+  x  = buffer;
+  dw = buffer + 1 * SDE_BLOCK;
+  a  = buffer + 2 * SDE_BLOCK;
+  b  = buffer + 3 * SDE_BLOCK;
+  db = buffer + 4 * SDE_BLOCK;
+  k  = buffer + 5 * SDE_BLOCK;
+  zj = buffer + 6 * SDE_BLOCK;
+
+  for(start = 0; start < paths; start += n) {
+    n = paths - start;
+    if( n > SDE_BLOCK )
+      n = SDE_BLOCK;
+
+    for(i = 0; i < n; ++i)
+      x[i] = model->x0;
+
+    for(step = 1; step <= steps; ++step) {
+      normal_fill(crandom, 0.0, sqdt, dw, n);
+
+      if( model->drift == NULL ) {
+        const double mudt = model->mu * dt;
+        const double sigma = model->sigma;
+        const double half_sigma2 = 0.5 * sigma * sigma;
+
+        if( milstein ) {
+          for(i = 0; i < n; ++i)
+            x[i] += x[i] * (mudt + sigma * dw[i] + half_sigma2 * (dw[i] * dw[i] - dt));
+        } else {
+          for(i = 0; i < n; ++i)
+            x[i] += x[i] * (mudt + sigma * dw[i]);
+        }
+      } else {
+        model->drift(model->ctx, x, a, n);
+        model->diffusion(model->ctx, x, b, milstein ? db : NULL, n);
+
+        if( milstein ) {
+          for(i = 0; i < n; ++i)
+            x[i] += a[i] * dt + b[i] * dw[i] + 0.5 * b[i] * db[i] * (dw[i] * dw[i] - dt);
+        } else {
+          for(i = 0; i < n; ++i)
+            x[i] += a[i] * dt + b[i] * dw[i];
+        }
+      }
+
+      if( jumps ) {
+        /* the sum of k normal(jumpMean, jumpStd) log-jumps is drawn at once */
+        const double jm = model->jumpMean;
+        const double js = model->jumpStd;
+
+        random_fill(crandom, k, n);
+        poisson_counts(k, n, model->jumpIntensity * dt);
+        normal_fill(crandom, 0.0, 1.0, zj, n);
+        for(i = 0; i < n; ++i)
+          x[i] *= (k[i] > 0.0) ? exp(k[i] * jm + sqrt(k[i]) * js * zj[i]) : 1.0;
+      }
+
+      observe(ctx, step, start, x, n);
+    }
+  }
+
+  free(buffer);
+  return 1;
+}
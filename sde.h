@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __sde_h__
+#define __sde_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Discretization scheme
+ */
+enum SdeScheme {
+  SDE_EULER,   /* Euler-Maruyama                     */
+  SDE_MILSTEIN /* Milstein (needs the diffusion derivative) */
+};
+
+
+/**
+ * Jump-diffusion model
+ *
+ *   dX = a(X) dt + b(X) dW,  X -> X * exp(J) at the jumps of a Poisson
+ *                            process with rate jumpIntensity,
+ *                            J ~ normal(jumpMean, jumpStd)
+ *
+ * If drift is NULL the model is the geometric Brownian motion
+ * a(x) = mu * x, b(x) = sigma * x, which is advanced by an inlined loop.
+ *
+ * Otherwise drift fills out[i] = a(x[i]) and diffusion fills
+ * out[i] = b(x[i]) and, when derivative is not NULL,
+ * derivative[i] = b'(x[i]). Both are called on whole blocks of paths.
+ */
+struct SdeModel {
+  double x0;
+
+  double mu;
+  double sigma;
+
+  void (* drift)(void * ctx, const double * x, double * out, size_t n);
+  void (* diffusion)(void * ctx, const double * x, double * out, double * derivative, size_t n);
+  void * ctx;
+
+  double jumpIntensity; /* 0.0 means no jumps */
+  double jumpMean;
+  double jumpStd;
+};
+
+
+/**
+ * Simulates paths paths of the model on [0, horizon] with steps equal steps.
+ *
+ * Paths are advanced in blocks which stay in cache; after every step
+ * observe(ctx, step, first, x, n) is called for the block (step = 1, ...,
+ * steps; x[i] is the value of path first + i), so payoffs are accumulated
+ * in the loop and whole paths are never stored.
+ * Normals and jump counts are drawn in bulk for a block per step.
+ *
+ * Returns 0 if there is not enough memory, 1 otherwise.
+ */
+int sde_simulate(const struct SdeModel * model, enum SdeScheme scheme, double horizon, int steps,
+                 struct cRandom * crandom, size_t paths,
+                 void (* observe)(void * ctx, int step, size_t first, const double * x, size_t n), void * ctx);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__sde_h__*/
@@ -0,0 +1,314 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "counters.h"
+#include "probes.h"
+#include "walk.h"
+
+
+/* Number of walkers advanced in lockstep */
+#define WALK_BLOCK (256)
+
+/* Number of uniforms drawn at once for the rejection sampling */
+#define WALK_POOL (4096)
+
+
+#if defined(__GNUC__)
+#define WALK_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define WALK_PREFETCH(p) ((void) 0)
+#endif
+
+
+struct RandomWalk {
+  int nodes;
+  const int * rowStart;
+  const int * columns;
+
+  /* alias tables of the edge weights, NULL for uniform choice */
+  double * prob;
+  int * alias;
+
+  /* node2vec biases divided by the largest one */
+  int secondOrder;
+  double back;
+  double in;
+  double out;
+};
+
+
+/**
+ * Uniforms drawn in bulk and consumed one by one
+ */
+struct UniformPool {
+  struct cRandom * crandom;
+  double buffer[WALK_POOL];
+  int position;
+};
+
+
+static double pool_next(struct UniformPool * pool) {
+  if( pool->position == WALK_POOL ) {
+    random_fill(pool->crandom, pool->buffer, WALK_POOL);
+    pool->position = 0;
+  }
+
+  return pool->buffer[pool->position++];
+}
+
+
+/**
+ * Builds the alias table of one row (Vose's method); alias is row-local
+ */
+static void alias_row(double * prob, int * alias, const double * weights, int n, int * work) {
+  int * small = work;
+  int * large = work + n;
+  double sum = 0.0;
+  int ns = 0, nl = 0, i, s, l;
+
+  for(i = 0; i < n; ++i) {
+    assert( 0.0 <= weights[i] );
+    sum += weights[i];
+  }
+  assert( 0.0 < sum );
+
+  for(i = 0; i < n; ++i) {
+    prob[i] = weights[i] * n / sum;
+    alias[i] = i;
+    if( prob[i] < 1.0 )
+      small[ns++] = i;
+    else
+      large[nl++] = i;
+  }
+
+  while( ns > 0 && nl > 0 ) {
+    s = small[--ns];
+    l = large[nl - 1];
+    alias[s] = l;
+    prob[l] -= 1.0 - prob[s];
+    if( prob[l] < 1.0 ) {
+      --nl;
+      small[ns++] = l;
+    }
+  }
+
+  /* the rest is 1 up to rounding */
+  while( nl > 0 )
+    prob[large[--nl]] = 1.0;
+  while( ns > 0 )
+    prob[small[--ns]] = 1.0;
+}
+
+
+/**
+ * Create a new walker
+ */
+struct RandomWalk * RandomWalkNew(int nodes, const int * rowStart, const int * columns, const double * weights, double p, double q) {
+  struct RandomWalk * walk;
+  const int edges = rowStart[nodes];
+  int * work = NULL;
+  double largest;
+  int v, k, degree, widest = 0;
+
+  assert( 0 < nodes );
+  assert( 0.0 < p && 0.0 < q );
+
+  walk = (struct RandomWalk *) calloc(1, sizeof(*walk));
+  if( walk == NULL )
+    return NULL;
+
+  walk->nodes = nodes;
+  walk->rowStart = rowStart;
+  walk->columns = columns;
+
+  walk->secondOrder = (p != 1.0 || q != 1.0);
+  largest = 1.0;
+  if( 1.0 / p > largest )
+    largest = 1.0 / p;
+  if( 1.0 / q > largest )
+    largest = 1.0 / q;
+  walk->back = 1.0 / p / largest;
+  walk->in = 1.0 / largest;
+  walk->out = 1.0 / q / largest;
+
+  for(v = 0; v < nodes; ++v) {
+    degree = rowStart[v + 1] - rowStart[v];
+    assert( 0 <= degree );
+    if( degree > widest )
+      widest = degree;
+    for(k = rowStart[v]; k < rowStart[v + 1]; ++k) {
+      assert( 0 <= columns[k] && columns[k] < nodes );
+      assert( !walk->secondOrder || k == rowStart[v] || columns[k - 1] < columns[k] );
+    }
+  }
+
+  if( weights != NULL ) {
+    walk->prob = (double *) malloc((edges + 1) * sizeof(double));
+    walk->alias = (int *) malloc((edges + 1) * sizeof(int));
+    work = (int *) malloc((2 * widest + 1) * sizeof(int));
+    if( walk->prob == NULL || walk->alias == NULL || work == NULL )
+      goto failure;
+
+    /* the tables are indexed like columns */
+    for(v = 0; v < nodes; ++v) {
+      if( rowStart[v + 1] > rowStart[v] )
+        alias_row(walk->prob + rowStart[v], walk->alias + rowStart[v], weights + rowStart[v], rowStart[v + 1] - rowStart[v], work);
+    }
+    free(work);
+  }
+
+  return walk;
+
+failure:
+  free(work);
+  free(walk->prob);
+  free(walk->alias);
+  free(walk);
+  return NULL;
+}
+
+
+/**
+ * Releases resources of a RandomWalk object
+ */
+void RandomWalkRelease(struct RandomWalk * walk) {
+  if( walk == NULL )
+    return;
+
+  free(walk->prob);
+  free(walk->alias);
+  free(walk);
+}
+
+
+/**
+ * Returns the edge of node start for the uniform u: the edge floor(u *
+ * degree), or its alias when the fraction is above the cell probability
+ */
+static int pick(const struct RandomWalk * walk, int start, int degree, double u) {
+  const double x = u * degree;
+  int k = (int) x;
+
+  if( walk->prob != NULL && x - k >= walk->prob[start + k] )
+    k = walk->alias[start + k];
+
+  return start + k;
+}
+
+
+/**
+ * Returns 1 if there is the edge from t to x (rows are sorted)
+ */
+static int has_edge(const struct RandomWalk * walk, int t, int x) {
+  int lo = walk->rowStart[t], hi = walk->rowStart[t + 1], middle;
+
+  while( lo < hi ) {
+    middle = lo + (hi - lo) / 2;
+    if( walk->columns[middle] < x )
+      lo = middle + 1;
+    else
+      hi = middle;
+  }
+
+  return lo < walk->rowStart[t + 1] && walk->columns[lo] == x;
+}
+
+
+/**
+ * Makes walks
+ */
+int RandomWalkFill(const struct RandomWalk * walk, struct cRandom * crandom,
+                   const int * starts, size_t walkers, int length, int * walks) {
+  struct UniformPool * pool = NULL;
+  int start[WALK_BLOCK];
+  int degree[WALK_BLOCK];
+  int current[WALK_BLOCK];
+  int previous[WALK_BLOCK];
+  double u[WALK_BLOCK];
+  size_t first;
+  int n, c, s, x, tries;
+  double bias;
+
+  if( walk->secondOrder ) {
+    pool = (struct UniformPool *) malloc(sizeof(*pool));
+    if( pool == NULL )
+      return 0;
+    pool->crandom = crandom;
+    pool->position = WALK_POOL;
+  }
+
+  for(first = 0; first < walkers; first += n) {
+    n = (walkers - first < WALK_BLOCK) ? (int) (walkers - first) : WALK_BLOCK;
+
+    for(c = 0; c < n; ++c) {
+      assert( 0 <= starts[first + c] && starts[first + c] < walk->nodes );
+      current[c] = starts[first + c];
+      previous[c] = -1;
+      if( length > 0 )
+        walks[(first + c) * length] = current[c];
+    }
+
+    for(s = 1; s < length; ++s) {
+      /* rows of the current nodes; their edge lists are read later */
+      for(c = 0; c < n; ++c) {
+        if( current[c] >= 0 ) {
+          start[c] = walk->rowStart[current[c]];
+          degree[c] = walk->rowStart[current[c] + 1] - start[c];
+          WALK_PREFETCH(walk->columns + start[c]);
+          if( walk->prob != NULL )
+            WALK_PREFETCH(walk->prob + start[c]);
+        } else {
+          start[c] = 0;
+          degree[c] = 0;
+        }
+      }
+
+      if( !walk->secondOrder ) {
+        random_fill(crandom, u, n);
+        for(c = 0; c < n; ++c)
+          current[c] = (degree[c] > 0) ? walk->columns[pick(walk, start[c], degree[c], u[c])] : -1;
+      } else {
+        for(c = 0; c < n; ++c) {
+          if( degree[c] == 0 ) {
+            current[c] = -1;
+            continue;
+          }
+
+          tries = 0;
+          for(;;) {
+            x = walk->columns[pick(walk, start[c], degree[c], pool_next(pool))];
+            if( previous[c] < 0 )
+              break;
+            if( x == previous[c] )
+              bias = walk->back;
+            else if( has_edge(walk, previous[c], x) )
+              bias = walk->in;
+            else
+              bias = walk->out;
+            if( bias >= 1.0 || pool_next(pool) < bias )
+              break;
+            CRANDOM_COUNT(CRANDOM_WALK_REJECTIONS, 1);
+            ++tries;
+          }
+          if( CRANDOM_PROBE_ENABLED(walk_loop) && tries + 1 > CRANDOM_PROBE_LOOP )
+            CRANDOM_PROBE2(walk_loop, tries + 1, current[c]);
+
+          previous[c] = current[c];
+          current[c] = x;
+        }
+      }
+
+      for(c = 0; c < n; ++c)
+        walks[(first + c) * length + s] = current[c];
+    }
+  }
+
+  free(pool);
+  return 1;
+}
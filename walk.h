@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2009 Alexander G. Pronchenkov. All rights reserved.
+ *
+ * The new BSD License is applied to this software.
+ */
+
+#ifndef __walk_h__
+#define __walk_h__
+
+#include <stddef.h>
+
+#include "crandom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Random walks on a graph in CSR form (DeepWalk, node2vec)
+ */
+struct RandomWalk;
+
+
+/**
+ * Create a new walker over the graph with nodes nodes: node v has the
+ * edges to columns[k] with weights weights[k], rowStart[v] <= k <
+ * rowStart[v + 1]. weights may be NULL (uniform choice of a neighbour).
+ *
+ * p and q are the return and in-out parameters of node2vec: after the
+ * move t -> v the edge v -> x is biased by 1 / p if x = t, by 1 if x is
+ * a neighbour of t and by 1 / q otherwise. p = q = 1.0 gives first order
+ * walks (DeepWalk).
+ *
+ * The graph is not copied and must outlive the walker.
+ * NOTE: use p > 0.0, q > 0.0; for p != 1.0 or q != 1.0 every row of
+ *       columns must be sorted.
+ *
+ * Returns NULL if there is not enough memory.
+ */
+struct RandomWalk * RandomWalkNew(int nodes, const int * rowStart, const int * columns, const double * weights, double p, double q);
+
+
+/**
+ * Releases resources of a RandomWalk object
+ */
+void RandomWalkRelease(struct RandomWalk * walk);
+
+
+/**
+ * Makes walkers walks of length nodes, the w-th starting at starts[w],
+ * and stores the w-th walk at walks[w * length], ..., walks[w * length +
+ * length - 1]. A walk which reaches a node without edges is padded by -1.
+ *
+ * Walkers advance in lockstep in blocks: bounded integers for the
+ * neighbour choice come from bulk uniform fills, and the edge lists of
+ * the next nodes are prefetched before they are read. Second order
+ * transitions are sampled by rejection against the largest bias.
+ *
+ * Returns 0 if there is not enough memory, 1 otherwise.
+ */
+int RandomWalkFill(const struct RandomWalk * walk, struct cRandom * crandom,
+                   const int * starts, size_t walkers, int length, int * walks);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*__walk_h__*/